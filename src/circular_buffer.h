@@ -25,6 +25,8 @@
 #ifndef _CIRCULAR_BUFFER_H_
 #define _CIRCULAR_BUFFER_H_
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <vector>
 #include <thread>
@@ -37,7 +39,7 @@ class CircularBuffer
 {
 public:
     CircularBuffer(std::size_t size) :
-        size_{size}, write_idx_{0}, read_idx_{0}, used_{0}
+        size_{size}, write_idx_{0}, read_idx_{0}, used_{0}, available_{0}
     {
         // allocate heap memory
         data_.resize(size);
@@ -61,20 +63,17 @@ public:
     {
         std::lock_guard lock(mutex_);
 
-        data_[write_idx_++] = std::forward<T>(elem);
+        push_locked(std::forward<T>(elem));
+    }
 
-        // handle wrap around
-        if (write_idx_ == size_)
-            write_idx_ = 0;
+    // like push(), but waits for free space instead of overwriting
+    void push_wait(T&& elem)
+    {
+        std::unique_lock lock(mutex_);
 
-        // update used and read index
-        if (used_ != size_)
-            used_++;
-        else
-            read_idx_ = write_idx_;
+        space_.wait(lock, [this] { return used_ != size_; });
 
-        // wake up one reader
-        cond_.notify_one();
+        push_locked(std::forward<T>(elem));
     }
 
     T pop()
@@ -84,16 +83,30 @@ public:
         // data available?
         cond_.wait(lock, [this] { return used_; });
 
-        auto elem = std::move(data_[read_idx_++]);
+        return pop_locked();
+    }
 
-        // handle wrap around
-        if (read_idx_ == size_)
-            read_idx_ = 0;
+    // like pop(), but busy polls for up to @spin before going to sleep
+    template<typename Rep, typename Period>
+    T pop_spin(std::chrono::duration<Rep, Period> spin)
+    {
+        auto deadline = std::chrono::steady_clock::now() + spin;
 
-        // update used
-        used_--;
+        do {
+            // don't touch the mutex until there's something
+            if (available_.load(std::memory_order_acquire)) {
+                std::lock_guard lock(mutex_);
 
-        return elem;
+                if (used_)
+                    return pop_locked();
+            }
+
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        } while (std::chrono::steady_clock::now() < deadline);
+
+        return pop();
     }
 
     T try_pop()
@@ -104,28 +117,54 @@ public:
         if (!used_)
             return T();
 
+        return pop_locked();
+    }
+
+private:
+    std::vector<T> data_;
+    std::size_t size_;
+    std::size_t write_idx_;
+    std::size_t read_idx_;
+    std::size_t used_;
+    std::atomic<std::size_t> available_;
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    std::condition_variable space_;
+
+    void push_locked(T&& elem)
+    {
+        data_[write_idx_++] = std::forward<T>(elem);
+
+        // handle wrap around
+        if (write_idx_ == size_)
+            write_idx_ = 0;
+
+        // update used and read index
+        if (used_ != size_)
+            used_++;
+        else
+            read_idx_ = write_idx_;
+        available_.store(used_, std::memory_order_release);
+
+        // wake up one reader
+        cond_.notify_one();
+    }
+
+    T pop_locked()
+    {
         auto elem = std::move(data_[read_idx_++]);
 
         // handle wrap around
         if (read_idx_ == size_)
             read_idx_ = 0;
 
-        // update used
+        // update used and wake up writer
         used_--;
+        available_.store(used_, std::memory_order_release);
+        space_.notify_one();
 
         return elem;
     }
-
-private:
-    std::vector<T> data_;
-    std::size_t size_;
-    std::size_t write_idx_;
-    std::size_t read_idx_;
-    std::size_t used_;
-    std::mutex mutex_;
-    std::condition_variable cond_;
 };
 
-using KtailNGBuffer = CircularBuffer<std::unique_ptr<std::string>>;
-
 #endif /* _CIRCULAR_BUFFER_H_ */
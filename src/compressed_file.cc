@@ -0,0 +1,120 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include <compressed_file.h>
+#include <gzip_file.h>
+#include <zstd_file.h>
+#include <ktailng_config.h>
+
+CompressedFile::Format CompressedFile::format(const std::string& filename)
+{
+    std::ifstream ifs(filename, std::ios::binary);
+    unsigned char magic[4] = {};
+
+    if (!ifs)
+        throw std::logic_error("Failed to open file");
+
+    ifs.read(reinterpret_cast<char *>(magic), sizeof(magic));
+
+    if (magic[0] == 0x1f && magic[1] == 0x8b)
+        return Format::GZIP;
+
+    if (magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+        return Format::ZSTD;
+
+    return Format::NONE;
+}
+
+std::unique_ptr<CompressedFile> CompressedFile::open(const std::string& filename,
+                                                     const std::string& index)
+{
+    switch (format(filename)) {
+    case Format::GZIP:
+#ifdef HAVE_ZLIB
+        return std::make_unique<GzipFile>(filename, index);
+#else
+        throw std::logic_error("No gzip support compiled in");
+#endif
+    case Format::ZSTD:
+#ifdef HAVE_ZSTD
+        return std::make_unique<ZstdFile>(filename);
+#else
+        throw std::logic_error("No zstd support compiled in");
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+std::string CompressedFile::tail(std::size_t lines)
+{
+    std::vector<std::string> parts;
+    std::size_t newlines = 0, size = 0, idx = chunks();
+    std::string data;
+
+    // walk backwards until enough lines are found
+    while (idx && newlines <= lines) {
+        std::string chunk;
+
+        // one more line than needed, the first one may be incomplete
+        read_chunk(--idx, chunk, lines + 1);
+
+        newlines += std::count(chunk.begin(), chunk.end(), '\n');
+        size += chunk.size();
+        parts.push_back(std::move(chunk));
+    }
+
+    data.reserve(size);
+    for (auto it = parts.rbegin(); it != parts.rend(); ++it)
+        data += *it;
+
+    // first line is incomplete, unless the beginning was reached
+    if (idx) {
+        auto first = data.find('\n');
+        data.erase(0, first == std::string::npos ? data.size() : first + 1);
+    }
+
+    return data;
+}
+
+void CompressedFile::trim(std::string& data, std::size_t lines)
+{
+    std::size_t newlines = 0;
+
+    for (auto pos = data.size(); pos; ) {
+        pos = data.rfind('\n', pos - 1);
+        if (pos == std::string::npos)
+            return;
+
+        if (++newlines > lines) {
+            data.erase(0, pos + 1);
+            return;
+        }
+    }
+}
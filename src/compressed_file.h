@@ -0,0 +1,74 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _COMPRESSED_FILE_H_
+#define _COMPRESSED_FILE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Random access to compressed files. Implementations split the uncompressed
+// data into chunks, which can be decompressed independently. That way the
+// last lines are found by decompressing only the final chunks.
+class CompressedFile
+{
+public:
+    CompressedFile(const std::string& filename) :
+        filename_{filename}
+    {}
+
+    virtual ~CompressedFile()
+    {}
+
+    enum class Format {
+        NONE,
+        GZIP,
+        ZSTD,
+    };
+
+    // detects the format by magic bytes, nothing is decompressed
+    static Format format(const std::string& filename);
+
+    // returns nullptr for uncompressed files
+    static std::unique_ptr<CompressedFile> open(const std::string& filename,
+                                                const std::string& index);
+
+    // returns the uncompressed data containing (at least) the last @lines lines
+    std::string tail(std::size_t lines);
+
+protected:
+    std::string filename_;
+
+    virtual std::size_t chunks() const = 0;
+
+    // appends chunk @idx to @out. Large chunks may be trimmed to their last
+    // @lines lines by trim().
+    virtual void read_chunk(std::size_t idx, std::string& out, std::size_t lines) = 0;
+
+    // drops whole lines from the front of @data, so that @lines newlines are left
+    static void trim(std::string& data, std::size_t lines);
+};
+
+#endif /* _COMPRESSED_FILE_H_ */
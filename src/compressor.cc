@@ -24,50 +24,26 @@
 
 #include <stdexcept>
 
-#include <writer.h>
+#include <compressor.h>
+#include <gzip_compressor.h>
+#include <zstd_compressor.h>
+#include <lz4_compressor.h>
+#include <ktailng_config.h>
 
-void Writer::read()
+std::unique_ptr<Compressor> Compressor::create(const std::string& algorithm)
 {
-    std::ifstream ifs(filename_);
-    auto old_pos = pos_, pos = pos_;
-
-    if (!ifs)
-        throw std::logic_error("Failed to open file");
-
-    ifs.seekg(pos_);
-
-    // read file
-    while (42) {
-        auto line = std::make_unique<std::string>();
-
-        std::getline(ifs, *line);
-
-        old_pos = pos;
-        pos = ifs.tellg();
-
-        if (ifs.eof())
-           break;
-
-        if (ifs.bad() || ifs.fail())
-            throw std::logic_error("I/O error while reading file");
-
-        buffer_.push(std::move(line));
-    }
-
-    pos_ = old_pos;
-}
-
-void Writer::write()
-{
-    read();
-
-    barrier_.arrive();
-
-    if (!follow_)
-        return;
-
-    while (42) {
-        watcher_.wait();
-        read();
-    }
+#ifdef HAVE_ZLIB
+    if (algorithm == "gzip")
+        return std::make_unique<GzipCompressor>();
+#endif
+#ifdef HAVE_ZSTD
+    if (algorithm == "zstd")
+        return std::make_unique<ZstdCompressor>();
+#endif
+#ifdef HAVE_LZ4
+    if (algorithm == "lz4")
+        return std::make_unique<Lz4Compressor>();
+#endif
+
+    throw std::logic_error("Unsupported compression algorithm");
 }
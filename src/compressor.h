@@ -0,0 +1,51 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _COMPRESSOR_H_
+#define _COMPRESSOR_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Streaming compression of the output. Data is batched internally until
+// flush() is called, which emits everything compressed so far without ending
+// the stream, so the receiving side can decode it right away.
+class Compressor
+{
+public:
+    Compressor()
+    {}
+
+    virtual ~Compressor()
+    {}
+
+    static std::unique_ptr<Compressor> create(const std::string& algorithm);
+
+    virtual void write(const char *data, std::size_t len) = 0;
+    virtual void flush() = 0;
+    virtual void finish() = 0;
+};
+
+#endif /* _COMPRESSOR_H_ */
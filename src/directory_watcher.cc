@@ -0,0 +1,126 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <stdexcept>
+
+#include <directory_watcher.h>
+#include <ktailng_config.h>
+
+#ifdef HAVE_INOTIFY
+
+#include <cerrno>
+
+#include <limits.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <method.h>
+#include <sys/inotify.h>
+
+DirectoryWatcher::DirectoryWatcher(const std::string& directory) :
+    directory_{directory}
+{
+    fd_ = inotify_init();
+    if (fd_ < 0)
+        throw std::logic_error("Failed to setup inotify");
+
+    wd_ = inotify_add_watch(fd_, directory_.c_str(),
+                            IN_MODIFY | IN_CREATE | IN_DELETE |
+                            IN_MOVED_FROM | IN_MOVED_TO);
+    if (wd_ < 0) {
+        close(fd_);
+        throw std::logic_error("Failed add inotify notifier");
+    }
+}
+
+DirectoryWatcher::~DirectoryWatcher()
+{
+    close(fd_);
+}
+
+const std::vector<DirectoryWatcher::Event>&
+DirectoryWatcher::wait(std::chrono::steady_clock::time_point deadline)
+{
+    // one read() may return many events, each followed by its name
+    alignas(struct inotify_event) char buf[64 * (sizeof(struct inotify_event) + NAME_MAX + 1)];
+    struct pollfd pfd{ fd_, POLLIN, 0 };
+
+    events_.clear();
+
+    while (events_.empty()) {
+        auto rc = poll(&pfd, 1, wait_timeout(deadline));
+        if (!rc)
+            break;
+
+        if (rc > 0)
+            rc = read(fd_, buf, sizeof(buf));
+        if (rc <= 0) {
+            if (errno == EINTR)
+                break;
+            throw std::logic_error("Inotify failed");
+        }
+
+        for (char *ptr = buf; ptr < buf + rc; ) {
+            auto *event = reinterpret_cast<struct inotify_event *>(ptr);
+
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                events_.push_back({ EventType::OVERFLOW, "" });
+                continue;
+            }
+
+            if (!event->len || event->mask & IN_ISDIR)
+                continue;
+
+            if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                events_.push_back({ EventType::CREATED, event->name });
+            else if (event->mask & IN_MODIFY)
+                events_.push_back({ EventType::MODIFIED, event->name });
+            else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+                events_.push_back({ EventType::REMOVED, event->name });
+        }
+    }
+
+    return events_;
+}
+
+#else
+
+DirectoryWatcher::DirectoryWatcher(const std::string& directory) :
+    directory_{directory}, fd_{-1}, wd_{-1}
+{
+    throw std::logic_error("Directory watching requires inotify");
+}
+
+DirectoryWatcher::~DirectoryWatcher()
+{}
+
+const std::vector<DirectoryWatcher::Event>&
+DirectoryWatcher::wait(std::chrono::steady_clock::time_point)
+{
+    return events_;
+}
+
+#endif
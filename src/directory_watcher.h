@@ -0,0 +1,66 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _DIRECTORY_WATCHER_H_
+#define _DIRECTORY_WATCHER_H_
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <ktailng_config.h>
+
+// Watches all entries of one directory with a single notifier. Only inotify
+// reports the names of changed entries, so this is not available on kqueue
+// systems.
+class DirectoryWatcher
+{
+public:
+    enum class EventType {
+        CREATED,
+        MODIFIED,
+        REMOVED,
+        OVERFLOW,
+    };
+
+    struct Event {
+        EventType type;
+        std::string name;
+    };
+
+    DirectoryWatcher(const std::string& directory);
+
+    virtual ~DirectoryWatcher();
+
+    // returns no events if @deadline passed without changes
+    const std::vector<Event>& wait(std::chrono::steady_clock::time_point deadline);
+
+private:
+    std::string directory_;
+    std::vector<Event> events_;
+    int fd_;
+    int wd_;
+};
+
+#endif /* _DIRECTORY_WATCHER_H_ */
@@ -25,7 +25,6 @@
 #ifndef _FILESYSTEM_WATCHER_H_
 #define _FILESYSTEM_WATCHER_H_
 
-#include <memory>
 #include <string>
 #include <stdexcept>
 
@@ -34,34 +33,28 @@
 #include <inotify.h>
 #include <ktailng_config.h>
 
-class FilesystemWatcher
+#ifdef HAVE_INOTIFY
+// Linux style
+using FilesystemWatcher = Inotify;
+#elif HAVE_KQUEUE
+// BSD style
+using FilesystemWatcher = Kqueue;
+#else
+class FilesystemWatcher : public Method
 {
 public:
     FilesystemWatcher(const std::string& filename) :
-        filename_{filename}
-    {
-#ifdef HAVE_INOTIFY
-        // Linux style
-        method_ = std::make_unique<Inotify>(filename_);
-#elif HAVE_KQUEUE
-        // BSD style
-        method_ = std::make_unique<Kqueue>(filename_);
-#endif
-    }
+        Method{filename}
+    {}
 
     virtual ~FilesystemWatcher()
     {}
 
-    virtual void wait()
+    bool wait(std::chrono::steady_clock::time_point)
     {
-        if (!method_)
-            throw std::logic_error("No filesystem watch mechanism found");
-        method_->wait();
+        throw std::logic_error("No filesystem watch mechanism found");
     }
-
-private:
-    std::string filename_;
-    std::unique_ptr<Method> method_;
 };
+#endif
 
 #endif /* _FILESYSTEM_WATCHER_H_ */
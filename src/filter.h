@@ -0,0 +1,138 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _FILTER_H_
+#define _FILTER_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <utility>
+
+#include <line_buffer.h>
+#include <stages.h>
+#include <type_list.h>
+
+// Stage between line splitting in the writers and the buffer. Lines are
+// dropped here as early as possible, so they don't cause any queue traffic.
+//
+// Only the enabled stages are part of a Filter, so a plain tail doesn't pay
+// for any feature it doesn't use. See dispatch_filter().
+template<typename... Stages>
+class Filter
+{
+public:
+    Filter(KtailNGBuffer& buffer, const FilterOptions& options) :
+        sink_{buffer}, stages_{Stages{sink_, options}...}, consulted_{0}
+    {}
+
+    // decides whether the next line is kept, before it is read at all
+    bool admit()
+    {
+        return std::apply([this](auto&... stage) {
+            consulted_ = 0;
+            return ((++consulted_, stage.admit()) && ...);
+        }, stages_);
+    }
+
+    // the last admitted or rejected line was incomplete and will show up
+    // again: undo what the stages asked by admit() did
+    void retry()
+    {
+        std::apply([this](auto&... stage) {
+            std::size_t i = 0;
+            ((i++ < consulted_ ? stage.retry() : void()), ...);
+        }, stages_);
+    }
+
+    // initial tail is done: lines must not be lost by overwriting them in the
+    // buffer anymore
+    void follow()
+    {
+        sink_.follow();
+        std::apply([](auto&... stage) { (stage.follow(), ...); }, stages_);
+    }
+
+    void push(std::unique_ptr<Line> line)
+    {
+        auto keep = std::apply([&line](auto&... stage) {
+            return (stage.process(*line) && ...);
+        }, stages_);
+
+        if (keep)
+            sink_.push(std::move(line));
+        else
+            sink_.recycle(std::move(line));
+    }
+
+    // called when the writer has consumed all available data
+    void idle()
+    {
+        std::apply([](auto&... stage) { (stage.idle(), ...); }, stages_);
+    }
+
+    // idle() has to be called by then, even without new data
+    std::chrono::steady_clock::time_point deadline() const
+    {
+        return std::apply([](const auto&... stage) {
+            return std::min({ std::chrono::steady_clock::time_point::max(), stage.deadline()... });
+        }, stages_);
+    }
+
+private:
+    Sink sink_;
+    std::tuple<Stages...> stages_;
+    std::size_t consulted_;
+};
+
+template<typename... Selected, typename F>
+void select_stages(TypeList<>, TypeList<Selected...>, const FilterOptions&, F&& f)
+{
+    f(TypeTag<Filter<Selected...>>{});
+}
+
+template<typename Next, typename... Rest, typename... Selected, typename F>
+void select_stages(TypeList<Next, Rest...>, TypeList<Selected...>,
+                   const FilterOptions& options, F&& f)
+{
+    if (Next::enabled(options))
+        select_stages(TypeList<Rest...>{}, TypeList<Selected..., Next>{},
+                      options, std::forward<F>(f));
+    else
+        select_stages(TypeList<Rest...>{}, TypeList<Selected...>{},
+                      options, std::forward<F>(f));
+}
+
+// Calls @f with TypeTag<Filter<...>> made of the stages enabled by @options.
+// Sampling and rate limiting come first, as they decide before a line is read.
+template<typename F>
+void dispatch_filter(const FilterOptions& options, F&& f)
+{
+    select_stages(TypeList<Sample, RateLimit, Project, Collapse>{}, TypeList<>{},
+                  options, std::forward<F>(f));
+}
+
+#endif /* _FILTER_H_ */
@@ -0,0 +1,361 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _GLOB_WRITER_H_
+#define _GLOB_WRITER_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <fstream>
+#include <limits>
+#include <list>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include <fnmatch.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <line_buffer.h>
+#include <barrier.h>
+#include <directory_watcher.h>
+#include <filter.h>
+
+// Like Writer, but for all files matching a shell pattern. The directory
+// part of the pattern is watched as a whole, so files showing up later on
+// are followed from their first line. Only the most recently active files
+// are kept open.
+template<typename Filter>
+class GlobWriter
+{
+public:
+    GlobWriter(KtailNGBuffer& buffer, KtailNGBarrier& barrier,
+               const std::string& pattern, bool follow, std::size_t max_open,
+               const FilterOptions& filter);
+
+    virtual ~GlobWriter()
+    {}
+
+    void write();
+
+private:
+    // state is kept per inode, so renamed files continue where they were
+    struct File {
+        std::ifstream ifs;
+        std::ifstream::pos_type pos;
+        typename std::list<File *>::iterator lru;
+        std::size_t names = 0;
+    };
+
+    KtailNGBuffer& buffer_;
+    KtailNGBarrier& barrier_;
+    std::string directory_;
+    std::string pattern_;
+    bool follow_;
+    std::size_t max_open_;
+    std::unordered_map<ino_t, File> files_;
+    std::unordered_map<std::string, ino_t> names_;
+    std::vector<ino_t> unnamed_;
+    std::list<File *> lru_;
+    std::unique_ptr<DirectoryWatcher> watcher_;
+    Filter filter_;
+
+    bool matches(const std::string& name) const;
+    void scan();
+    void read(const std::string& name);
+    void read_lines(File& file);
+    void link(const std::string& name, ino_t inode);
+    void unlink(const std::string& name);
+    void prune();
+    void open(const std::string& path, File& file);
+    void close(File& file);
+};
+
+template<typename Filter>
+GlobWriter<Filter>::GlobWriter(KtailNGBuffer& buffer, KtailNGBarrier& barrier,
+                               const std::string& pattern, bool follow,
+                               std::size_t max_open, const FilterOptions& filter) :
+    buffer_{buffer}, barrier_{barrier}, follow_{follow}, max_open_{max_open},
+    filter_{buffer, filter}
+{
+    auto slash = pattern.rfind('/');
+
+    if (slash == std::string::npos) {
+        directory_ = ".";
+        pattern_ = pattern;
+    } else {
+        directory_ = slash ? pattern.substr(0, slash) : "/";
+        pattern_ = pattern.substr(slash + 1);
+    }
+
+    if (directory_.find_first_of("*?[") != std::string::npos)
+        throw std::logic_error("Wildcards are only supported in the file name");
+    if (pattern_.empty())
+        throw std::logic_error("Empty file name pattern");
+    if (!max_open_)
+        throw std::logic_error("At least one file has to be kept open");
+
+    // setup watch before the initial scan, so no new file is missed
+    if (follow_)
+        watcher_ = std::make_unique<DirectoryWatcher>(directory_);
+}
+
+template<typename Filter>
+bool GlobWriter<Filter>::matches(const std::string& name) const
+{
+    return !fnmatch(pattern_.c_str(), name.c_str(), FNM_PERIOD);
+}
+
+template<typename Filter>
+void GlobWriter<Filter>::scan()
+{
+    std::vector<std::string> names;
+    auto *dir = opendir(directory_.c_str());
+
+    if (!dir)
+        throw std::logic_error("Failed to open directory");
+
+    while (auto *entry = readdir(dir)) {
+        std::string name{entry->d_name};
+
+        if (matches(name))
+            names.push_back(std::move(name));
+    }
+    closedir(dir);
+
+    // oldest files first, given the usual date or counter suffixes
+    std::sort(names.begin(), names.end());
+
+    for (auto&& name : names)
+        read(name);
+}
+
+template<typename Filter>
+void GlobWriter<Filter>::link(const std::string& name, ino_t inode)
+{
+    auto it = names_.find(name);
+
+    if (it != names_.end()) {
+        if (it->second == inode)
+            return;
+        unlink(name);
+    }
+
+    names_[name] = inode;
+    files_[inode].names++;
+}
+
+template<typename Filter>
+void GlobWriter<Filter>::unlink(const std::string& name)
+{
+    auto it = names_.find(name);
+
+    if (it == names_.end())
+        return;
+
+    // the file may show up under another name later in the same batch
+    if (!--files_[it->second].names)
+        unnamed_.push_back(it->second);
+    names_.erase(it);
+}
+
+template<typename Filter>
+void GlobWriter<Filter>::prune()
+{
+    for (auto&& inode : unnamed_) {
+        auto it = files_.find(inode);
+
+        if (it != files_.end() && !it->second.names) {
+            close(it->second);
+            files_.erase(it);
+        }
+    }
+    unnamed_.clear();
+}
+
+template<typename Filter>
+void GlobWriter<Filter>::open(const std::string& path, File& file)
+{
+    // make room by closing the least recently used file
+    if (lru_.size() >= max_open_)
+        close(*lru_.back());
+
+    file.ifs.open(path);
+    if (!file.ifs)
+        return;
+
+    lru_.push_front(&file);
+    file.lru = lru_.begin();
+}
+
+template<typename Filter>
+void GlobWriter<Filter>::close(File& file)
+{
+    if (!file.ifs.is_open())
+        return;
+
+    file.ifs.close();
+    lru_.erase(file.lru);
+}
+
+template<typename Filter>
+void GlobWriter<Filter>::read(const std::string& name)
+{
+    struct stat st;
+    auto path = directory_ + "/" + name;
+
+    if (stat(path.c_str(), &st) || !S_ISREG(st.st_mode))
+        return;
+
+    // name refers to another file now, e.g. after rotation: the old one may
+    // still hold unread lines
+    auto it = names_.find(name);
+    if (it != names_.end() && it->second != st.st_ino) {
+        auto& old = files_[it->second];
+
+        if (old.ifs.is_open())
+            read_lines(old);
+    }
+    link(name, st.st_ino);
+
+    auto& file = files_[st.st_ino];
+
+    // start over on truncated files
+    if (st.st_size < static_cast<std::streamoff>(file.pos))
+        file.pos = 0;
+
+    if (file.ifs.is_open())
+        lru_.splice(lru_.begin(), lru_, file.lru);
+    else
+        open(path, file);
+
+    if (!file.ifs.is_open())
+        return;
+
+    read_lines(file);
+}
+
+// reads all complete lines of the open file from its position on
+template<typename Filter>
+void GlobWriter<Filter>::read_lines(File& file)
+{
+    auto& ifs = file.ifs;
+    auto old_pos = file.pos, pos = file.pos;
+
+    ifs.clear();
+    ifs.seekg(file.pos);
+
+    // read file
+    while (42) {
+        // skip dropped lines without reading them into memory
+        if (!filter_.admit()) {
+            ifs.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+            old_pos = pos;
+            pos = ifs.tellg();
+
+            if (ifs.eof()) {
+                filter_.retry();
+                break;
+            }
+
+            if (ifs.bad() || ifs.fail())
+                throw std::logic_error("I/O error while reading file");
+
+            continue;
+        }
+
+        auto line = buffer_.allocate();
+
+        std::getline(ifs, *line);
+
+        old_pos = pos;
+        pos = ifs.tellg();
+
+        if (ifs.eof()) {
+            filter_.retry();
+            buffer_.recycle(std::move(line));
+            break;
+        }
+
+        if (ifs.bad() || ifs.fail())
+            throw std::logic_error("I/O error while reading file");
+
+        filter_.push(std::move(line));
+    }
+
+    file.pos = old_pos;
+}
+
+template<typename Filter>
+void GlobWriter<Filter>::write()
+{
+    scan();
+    prune();
+    filter_.idle();
+
+    barrier_.arrive();
+
+    if (!follow_)
+        return;
+
+    filter_.follow();
+
+    while (42) {
+        for (auto&& event : watcher_->wait(filter_.deadline())) {
+            using EventType = DirectoryWatcher::EventType;
+
+            if (event.type == EventType::OVERFLOW) {
+                scan();
+                continue;
+            }
+
+            if (!matches(event.name))
+                continue;
+
+            switch (event.type) {
+            case EventType::CREATED:
+            case EventType::MODIFIED:
+                read(event.name);
+                break;
+            case EventType::REMOVED:
+                unlink(event.name);
+                break;
+            default:
+                break;
+            }
+        }
+
+        // renamed files have been linked to their new name by now
+        prune();
+
+        filter_.idle();
+    }
+}
+
+#endif /* _GLOB_WRITER_H_ */
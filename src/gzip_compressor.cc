@@ -0,0 +1,84 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <ktailng_config.h>
+
+#ifdef HAVE_ZLIB
+
+#include <iostream>
+#include <stdexcept>
+
+#include <gzip_compressor.h>
+
+GzipCompressor::GzipCompressor() :
+    strm_{}, out_(64 * 1024)
+{
+    // window bits + 16: gzip header instead of zlib
+    if (deflateInit2(&strm_, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                     15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        throw std::logic_error("Failed to setup zlib");
+}
+
+GzipCompressor::~GzipCompressor()
+{
+    deflateEnd(&strm_);
+}
+
+void GzipCompressor::deflate(int mode)
+{
+    do {
+        strm_.next_out = out_.data();
+        strm_.avail_out = out_.size();
+
+        auto ret = ::deflate(&strm_, mode);
+        if (ret == Z_STREAM_ERROR)
+            throw std::logic_error("Compression failed");
+
+        std::cout.write(reinterpret_cast<const char *>(out_.data()),
+                        out_.size() - strm_.avail_out);
+    } while (!strm_.avail_out);
+}
+
+void GzipCompressor::write(const char *data, std::size_t len)
+{
+    strm_.next_in = reinterpret_cast<unsigned char *>(const_cast<char *>(data));
+    strm_.avail_in = len;
+
+    while (strm_.avail_in)
+        deflate(Z_NO_FLUSH);
+}
+
+void GzipCompressor::flush()
+{
+    deflate(Z_SYNC_FLUSH);
+    std::cout.flush();
+}
+
+void GzipCompressor::finish()
+{
+    deflate(Z_FINISH);
+    std::cout.flush();
+}
+
+#endif
@@ -0,0 +1,319 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <ktailng_config.h>
+
+#ifdef HAVE_ZLIB
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <zlib.h>
+#include <sys/stat.h>
+
+#include <gzip_file.h>
+
+namespace {
+
+constexpr std::size_t WINDOW_SIZE = 32768;
+constexpr std::size_t INPUT_SIZE = 16384;
+constexpr std::uint64_t SPAN = 1024 * 1024;
+constexpr std::size_t RING_SIZE = 8;
+constexpr char INDEX_MAGIC[8] = { 'K', 'T', 'G', 'Z', 'I', 'D', 'X', '1' };
+
+class Inflater
+{
+public:
+    Inflater(int window_bits)
+    {
+        if (inflateInit2(&strm, window_bits) != Z_OK)
+            throw std::logic_error("Failed to setup zlib");
+    }
+
+    ~Inflater()
+    {
+        inflateEnd(&strm);
+    }
+
+    z_stream strm{};
+};
+
+template<typename T>
+void write_value(std::ofstream& ofs, const T& value)
+{
+    ofs.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template<typename T>
+void read_value(std::ifstream& ifs, T& value)
+{
+    ifs.read(reinterpret_cast<char *>(&value), sizeof(value));
+}
+
+}
+
+GzipFile::GzipFile(const std::string& filename, const std::string& index) :
+    CompressedFile(filename), total_out_{0}
+{
+    struct stat st;
+
+    if (stat(filename_.c_str(), &st))
+        throw std::logic_error("Failed to stat file");
+
+    size_ = st.st_size;
+    mtime_ = st.st_mtime;
+
+    if (!index.empty() && load_index(index))
+        return;
+
+    build_index(0, index.empty());
+
+    if (!index.empty())
+        save_index(index);
+}
+
+// Windows are kept for checkpoints from @first on, with @ring only for the
+// last RING_SIZE of them.
+void GzipFile::build_index(std::size_t first, bool ring)
+{
+    std::ifstream ifs(filename_, std::ios::binary);
+    std::vector<unsigned char> input(INPUT_SIZE), window(WINDOW_SIZE);
+    std::uint64_t totin = 0, totout = 0, last = 0;
+    Inflater inflater(47);
+    auto& strm = inflater.strm;
+    int ret = Z_OK;
+
+    if (!ifs)
+        throw std::logic_error("Failed to open file");
+
+    points_.clear();
+
+    // inflate the whole file block by block and remember the positions
+    while (42) {
+        if (!strm.avail_in) {
+            ifs.read(reinterpret_cast<char *>(input.data()), input.size());
+            if (ifs.bad())
+                throw std::logic_error("I/O error while reading file");
+
+            strm.avail_in = ifs.gcount();
+            strm.next_in = input.data();
+
+            if (!strm.avail_in) {
+                if (ret == Z_STREAM_END)
+                    break;
+                throw std::logic_error("Unexpected end of gzip file");
+            }
+        }
+
+        // another gzip member follows
+        if (ret == Z_STREAM_END)
+            inflateReset(&strm);
+
+        if (!strm.avail_out) {
+            strm.avail_out = WINDOW_SIZE;
+            strm.next_out = window.data();
+        }
+
+        totin += strm.avail_in;
+        totout += strm.avail_out;
+        ret = inflate(&strm, Z_BLOCK);
+        totin -= strm.avail_in;
+        totout -= strm.avail_out;
+
+        if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR)
+            throw std::logic_error("Corrupt gzip file");
+
+        if (ret == Z_STREAM_END)
+            continue;
+
+        // add checkpoint at the end of a block, but not after the last one
+        if ((strm.data_type & 128) && !(strm.data_type & 64) &&
+            (points_.empty() || totout - last > SPAN)) {
+            Point point{ totout, totin, strm.data_type & 7, {} };
+            auto left = strm.avail_out;
+            auto n = points_.size();
+
+            if (n >= first) {
+                // take over the window of the point leaving the ring
+                if (ring && n >= first + RING_SIZE)
+                    point.window.swap(points_[n - RING_SIZE].window);
+                else
+                    point.window.resize(WINDOW_SIZE);
+
+                // window is circular
+                if (left)
+                    std::memcpy(point.window.data(), window.data() + WINDOW_SIZE - left, left);
+                if (left < WINDOW_SIZE)
+                    std::memcpy(point.window.data() + left, window.data(), WINDOW_SIZE - left);
+            }
+
+            points_.push_back(std::move(point));
+            last = totout;
+        }
+    }
+
+    total_out_ = totout;
+}
+
+bool GzipFile::load_index(const std::string& index)
+{
+    std::ifstream ifs(index, std::ios::binary);
+    char magic[sizeof(INDEX_MAGIC)];
+    std::uint64_t size, count;
+    std::int64_t mtime;
+
+    if (!ifs)
+        return false;
+
+    ifs.read(magic, sizeof(magic));
+    read_value(ifs, size);
+    read_value(ifs, mtime);
+    read_value(ifs, total_out_);
+    read_value(ifs, count);
+
+    // index belongs to a different file?
+    if (!ifs || std::memcmp(magic, INDEX_MAGIC, sizeof(magic)) ||
+        size != size_ || mtime != mtime_)
+        return false;
+
+    points_.resize(count);
+    for (auto&& point : points_) {
+        read_value(ifs, point.out);
+        read_value(ifs, point.in);
+        read_value(ifs, point.bits);
+        point.window.resize(WINDOW_SIZE);
+        ifs.read(reinterpret_cast<char *>(point.window.data()), WINDOW_SIZE);
+    }
+
+    if (!ifs) {
+        points_.clear();
+        return false;
+    }
+
+    return true;
+}
+
+void GzipFile::save_index(const std::string& index) const
+{
+    std::ofstream ofs(index, std::ios::binary | std::ios::trunc);
+    std::uint64_t count = points_.size();
+
+    ofs.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    write_value(ofs, size_);
+    write_value(ofs, mtime_);
+    write_value(ofs, total_out_);
+    write_value(ofs, count);
+
+    for (auto&& point : points_) {
+        write_value(ofs, point.out);
+        write_value(ofs, point.in);
+        write_value(ofs, point.bits);
+        ofs.write(reinterpret_cast<const char *>(point.window.data()), WINDOW_SIZE);
+    }
+
+    if (!ofs)
+        throw std::logic_error("Failed to write gzip index");
+}
+
+void GzipFile::read_chunk(std::size_t idx, std::string& out, std::size_t)
+{
+    // window was dropped: index again, keeping twice as many windows as
+    // were needed so far (chunks are read backwards)
+    if (points_[idx].window.empty()) {
+        auto kept = points_.size() - idx;
+
+        build_index(idx >= kept ? idx + 1 - kept : 0, false);
+    }
+
+    std::ifstream ifs(filename_, std::ios::binary);
+    std::vector<unsigned char> input(INPUT_SIZE);
+    const auto& point = points_[idx];
+    auto end = idx + 1 < points_.size() ? points_[idx + 1].out : total_out_;
+    Inflater inflater(-15);
+    auto& strm = inflater.strm;
+    std::size_t skip = 0;
+    bool raw = true;
+
+    if (!ifs)
+        throw std::logic_error("Failed to open file");
+
+    // resume raw inflate in the middle of the stream
+    ifs.seekg(point.in - (point.bits ? 1 : 0));
+    if (point.bits) {
+        auto c = ifs.get();
+        if (c == std::ifstream::traits_type::eof())
+            throw std::logic_error("Unexpected end of gzip file");
+        inflatePrime(&strm, point.bits, c >> (8 - point.bits));
+    }
+    inflateSetDictionary(&strm, point.window.data(), WINDOW_SIZE);
+
+    out.resize(end - point.out);
+    strm.next_out = reinterpret_cast<unsigned char *>(out.data());
+    strm.avail_out = out.size();
+
+    while (strm.avail_out) {
+        if (!strm.avail_in) {
+            ifs.read(reinterpret_cast<char *>(input.data()), input.size());
+            if (ifs.bad())
+                throw std::logic_error("I/O error while reading file");
+
+            strm.avail_in = ifs.gcount();
+            strm.next_in = input.data();
+
+            if (!strm.avail_in)
+                throw std::logic_error("Unexpected end of gzip file");
+        }
+
+        if (skip) {
+            auto len = std::min<std::size_t>(skip, strm.avail_in);
+
+            strm.next_in += len;
+            strm.avail_in -= len;
+            skip -= len;
+            continue;
+        }
+
+        auto ret = inflate(&strm, Z_NO_FLUSH);
+
+        // chunk spans multiple gzip members: skip trailer of the raw stream
+        // and let zlib parse the following headers
+        if (ret == Z_STREAM_END) {
+            if (raw) {
+                skip = 8;
+                raw = false;
+                inflateReset2(&strm, 47);
+            } else {
+                inflateReset(&strm);
+            }
+            continue;
+        }
+
+        if (ret != Z_OK)
+            throw std::logic_error("Corrupt gzip file");
+    }
+}
+
+#endif
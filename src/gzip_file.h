@@ -0,0 +1,80 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _GZIP_FILE_H_
+#define _GZIP_FILE_H_
+
+#include <ktailng_config.h>
+
+#ifdef HAVE_ZLIB
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <compressed_file.h>
+
+// Gzip files are split at deflate block boundaries roughly every SPAN bytes of
+// uncompressed data. Each checkpoint stores the bit position and the 32 KiB
+// window needed to resume inflating from there. Building this index requires
+// one pass over the file, so it can be cached in an index file. Without index
+// file only the windows of the last checkpoints are kept, as only the end of
+// the file is of interest.
+class GzipFile : public CompressedFile
+{
+public:
+    GzipFile(const std::string& filename, const std::string& index);
+
+    virtual ~GzipFile()
+    {}
+
+protected:
+    virtual std::size_t chunks() const override
+    {
+        return points_.size();
+    }
+
+    virtual void read_chunk(std::size_t idx, std::string& out, std::size_t lines) override;
+
+private:
+    struct Point {
+        std::uint64_t out;
+        std::uint64_t in;
+        std::int32_t bits;
+        std::vector<unsigned char> window;
+    };
+
+    std::vector<Point> points_;
+    std::uint64_t total_out_;
+    std::uint64_t size_;
+    std::int64_t mtime_;
+
+    void build_index(std::size_t first, bool ring);
+    bool load_index(const std::string& index);
+    void save_index(const std::string& index) const;
+};
+
+#endif
+
+#endif /* _GZIP_FILE_H_ */
@@ -27,7 +27,10 @@
 #ifdef HAVE_INOTIFY
 
 #include <stdexcept>
+#include <cerrno>
 
+#include <limits.h>
+#include <poll.h>
 #include <unistd.h>
 #include <sys/inotify.h>
 
@@ -36,6 +39,17 @@
 Inotify::Inotify(const std::string& filename) :
     Method(filename)
 {
+    auto slash = filename_.rfind('/');
+    std::string directory;
+
+    if (slash == std::string::npos) {
+        directory = ".";
+        basename_ = filename_;
+    } else {
+        directory = slash ? filename_.substr(0, slash) : "/";
+        basename_ = filename_.substr(slash + 1);
+    }
+
     fd_ = inotify_init();
     if (fd_ < 0)
         throw std::logic_error("Failed to setup inotify");
@@ -43,22 +57,51 @@ Inotify::Inotify(const std::string& filename) :
     wd_ = inotify_add_watch(fd_, filename_.c_str(), IN_MODIFY);
     if (wd_ < 0)
         throw std::logic_error("Failed add inotify notifier");
+
+    // notice when the file is replaced, e.g. by log rotation
+    dir_wd_ = inotify_add_watch(fd_, directory.c_str(), IN_CREATE | IN_MOVED_TO);
+    if (dir_wd_ < 0)
+        throw std::logic_error("Failed add inotify notifier");
 }
 
-void Inotify::wait()
+bool Inotify::wait(std::chrono::steady_clock::time_point deadline)
 {
+    alignas(struct inotify_event) char buf[16 * (sizeof(struct inotify_event) + NAME_MAX + 1)];
+    struct pollfd pfd{ fd_, POLLIN, 0 };
+
     while (42) {
-        struct inotify_event event;
+        auto rc = poll(&pfd, 1, wait_timeout(deadline));
+        if (!rc)
+            return false;
 
-        auto rc = read(fd_, &event, sizeof(event));
+        if (rc > 0)
+            rc = read(fd_, buf, sizeof(buf));
         if (rc <= 0) {
             if (errno == EINTR)
-                break;
+                return true;
             throw std::logic_error("Inotify failed");
         }
 
-        if (event.mask & IN_MODIFY)
-            break;
+        auto modified = false;
+
+        for (char *ptr = buf; ptr < buf + rc; ) {
+            auto *event = reinterpret_cast<struct inotify_event *>(ptr);
+
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->wd == wd_ && event->mask & IN_MODIFY)
+                modified = true;
+
+            // new file: move watch over
+            if (event->wd == dir_wd_ && event->len && basename_ == event->name) {
+                inotify_rm_watch(fd_, wd_);
+                wd_ = inotify_add_watch(fd_, filename_.c_str(), IN_MODIFY);
+                modified = true;
+            }
+        }
+
+        if (modified)
+            return true;
     }
 }
 
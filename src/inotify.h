@@ -29,6 +29,7 @@
 
 #ifdef HAVE_INOTIFY
 
+#include <chrono>
 #include <string>
 
 #include <method.h>
@@ -41,11 +42,14 @@ public:
     virtual ~Inotify()
     {}
 
-    virtual void wait() override;
+    // returns false if @deadline passed without changes
+    bool wait(std::chrono::steady_clock::time_point deadline);
 
 private:
     int fd_;
     int wd_;
+    int dir_wd_;
+    std::string basename_;
 };
 
 #endif
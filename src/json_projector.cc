@@ -0,0 +1,304 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <json_projector.h>
+
+namespace {
+
+constexpr std::size_t BLOCK_SIZE = 64;
+
+// one block of 64 bytes, compared against single characters at once
+class Block
+{
+public:
+#if defined(__AVX2__)
+    Block(const char *data) :
+        lo_{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(data))},
+        hi_{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + 32))}
+    {}
+
+    std::uint64_t eq(char c) const
+    {
+        auto needle = _mm256_set1_epi8(c);
+        std::uint64_t lo = static_cast<std::uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo_, needle)));
+        std::uint64_t hi = static_cast<std::uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi_, needle)));
+
+        return lo | hi << 32;
+    }
+
+private:
+    __m256i lo_, hi_;
+#elif defined(__SSE2__)
+    Block(const char *data)
+    {
+        for (int i = 0; i < 4; ++i)
+            chunks_[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 16 * i));
+    }
+
+    std::uint64_t eq(char c) const
+    {
+        auto needle = _mm_set1_epi8(c);
+        std::uint64_t mask = 0;
+
+        for (int i = 0; i < 4; ++i)
+            mask |= static_cast<std::uint64_t>(static_cast<std::uint16_t>(
+                _mm_movemask_epi8(_mm_cmpeq_epi8(chunks_[i], needle)))) << (16 * i);
+
+        return mask;
+    }
+
+private:
+    __m128i chunks_[4];
+#else
+    Block(const char *data) :
+        data_{data}
+    {}
+
+    std::uint64_t eq(char c) const
+    {
+        std::uint64_t mask = 0;
+
+        for (std::size_t i = 0; i < BLOCK_SIZE; ++i)
+            mask |= static_cast<std::uint64_t>(data_[i] == c) << i;
+
+        return mask;
+    }
+
+private:
+    const char *data_;
+#endif
+};
+
+// bit i is set, if an odd number of bits <= i is set
+inline std::uint64_t prefix_xor(std::uint64_t bits)
+{
+#if defined(__PCLMUL__)
+    return _mm_cvtsi128_si64(_mm_clmulepi64_si128(
+        _mm_set_epi64x(0, bits), _mm_set1_epi8(static_cast<char>(0xff)), 0));
+#else
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+#endif
+}
+
+// characters preceded by an odd number of backslashes
+inline std::uint64_t escaped_chars(std::uint64_t backslash, std::uint64_t& prev_escaped)
+{
+    constexpr std::uint64_t even_bits = 0x5555555555555555ULL;
+    std::uint64_t even_starts;
+
+    backslash &= ~prev_escaped;
+
+    auto follows_escape = backslash << 1 | prev_escaped;
+    auto odd_starts = backslash & ~even_bits & ~follows_escape;
+
+    prev_escaped = __builtin_add_overflow(odd_starts, backslash, &even_starts);
+
+    return (even_bits ^ (even_starts << 1)) & follows_escape;
+}
+
+inline bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+}
+
+void JsonProjector::add_value(const std::string& line, std::size_t key_start, std::size_t key_end,
+                              std::size_t value_start, std::size_t value_end)
+{
+    auto key_len = key_end - key_start;
+
+    for (std::size_t i = 0; i < fields_.size(); ++i) {
+        if (values_[i].len || fields_[i].size() != key_len ||
+            std::memcmp(fields_[i].data(), line.data() + key_start, key_len))
+            continue;
+
+        values_[i] = { value_start, value_end - value_start };
+        break;
+    }
+}
+
+bool JsonProjector::project(const std::string& line, std::string& out)
+{
+    enum class State { BEGIN, KEY, KEY_END, COLON, VALUE, DONE } state = State::BEGIN;
+    std::uint64_t prev_escaped = 0, prev_in_string = 0, stack = 0;
+    std::size_t depth = 0, key_start = 0, key_end = 0, value_start = 0,
+        value_end = 0, begin = 0, end = 0;
+    bool empty = false;
+
+    for (auto&& value : values_)
+        value = { 0, 0 };
+
+    for (std::size_t base = 0; base < line.size(); base += BLOCK_SIZE) {
+        const char *data = line.data() + base;
+        char padded[BLOCK_SIZE];
+
+        // last block is padded by spaces
+        if (line.size() - base < BLOCK_SIZE) {
+            std::memset(padded, ' ', sizeof(padded));
+            std::memcpy(padded, data, line.size() - base);
+            data = padded;
+        }
+
+        Block block(data);
+        auto escaped = escaped_chars(block.eq('\\'), prev_escaped);
+        auto quotes = block.eq('"') & ~escaped;
+        auto in_string = prefix_xor(quotes) ^ prev_in_string;
+        auto structural = (block.eq('{') | block.eq('}') | block.eq('[') |
+                           block.eq(']') | block.eq(':') | block.eq(',')) & ~in_string;
+        auto tokens = structural | quotes;
+
+        prev_in_string = static_cast<std::uint64_t>(static_cast<std::int64_t>(in_string) >> 63);
+
+        // visit structural characters only
+        while (tokens) {
+            auto pos = base + __builtin_ctzll(tokens);
+            auto c = line[pos];
+
+            tokens &= tokens - 1;
+
+            switch (state) {
+            case State::BEGIN:
+                if (c != '{')
+                    return false;
+                begin = pos;
+                stack = 1;
+                depth = 1;
+                empty = true;
+                state = State::KEY;
+                break;
+            case State::KEY:
+                if (c == '}' && empty) {
+                    end = pos;
+                    state = State::DONE;
+                    break;
+                }
+                if (c != '"')
+                    return false;
+                key_start = pos + 1;
+                state = State::KEY_END;
+                break;
+            case State::KEY_END:
+                key_end = pos;
+                state = State::COLON;
+                break;
+            case State::COLON:
+                if (c != ':')
+                    return false;
+                value_start = pos + 1;
+                state = State::VALUE;
+                break;
+            case State::VALUE:
+                if (c == '"')
+                    break;
+
+                if (c == '{' || c == '[') {
+                    if (depth == 64)
+                        return false;
+                    stack = stack << 1 | (c == '{');
+                    depth++;
+                    break;
+                }
+
+                if (c == '}' || c == ']') {
+                    if ((stack & 1) != (c == '}'))
+                        return false;
+                    stack >>= 1;
+                    depth--;
+                }
+
+                if (depth > 1 || (depth == 1 && c != ','))
+                    break;
+
+                // end of a top level value
+                value_end = pos;
+                while (value_start < value_end && is_space(line[value_start]))
+                    value_start++;
+                while (value_end > value_start && is_space(line[value_end - 1]))
+                    value_end--;
+                if (value_start == value_end)
+                    return false;
+                add_value(line, key_start, key_end, value_start, value_end);
+
+                if (depth) {
+                    empty = false;
+                    state = State::KEY;
+                } else {
+                    end = pos;
+                    state = State::DONE;
+                }
+                break;
+            case State::DONE:
+                return false;
+            }
+        }
+    }
+
+    if (state != State::DONE || prev_in_string)
+        return false;
+
+    // nothing but spaces around the object
+    for (std::size_t i = 0; i < begin; ++i)
+        if (!is_space(line[i]))
+            return false;
+    for (std::size_t i = end + 1; i < line.size(); ++i)
+        if (!is_space(line[i]))
+            return false;
+
+    out.clear();
+    out += '{';
+
+    for (std::size_t i = 0; i < fields_.size(); ++i) {
+        if (!values_[i].len)
+            continue;
+
+        if (out.size() > 1)
+            out += ',';
+        out += '"';
+        out += fields_[i];
+        out += "\":";
+        out.append(line, values_[i].start, values_[i].len);
+    }
+
+    if (out.size() == 1)
+        return false;
+
+    out += '}';
+
+    return true;
+}
@@ -0,0 +1,63 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _JSON_PROJECTOR_H_
+#define _JSON_PROJECTOR_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Extracts top level fields of JSON objects without parsing them. The line is
+// scanned in blocks of 64 bytes, building bitmaps of quotes, backslashes and
+// structural characters (SIMD where available). Only the structural
+// characters outside of strings are visited afterwards. Values are copied as
+// they are, and objects are validated only structurally.
+class JsonProjector
+{
+public:
+    JsonProjector(const std::vector<std::string>& fields) :
+        fields_{fields}, values_(fields.size())
+    {}
+
+    virtual ~JsonProjector()
+    {}
+
+    // returns false if @line is not an object or has none of the fields
+    bool project(const std::string& line, std::string& out);
+
+private:
+    struct Span {
+        std::size_t start;
+        std::size_t len;
+    };
+
+    std::vector<std::string> fields_;
+    std::vector<Span> values_;
+
+    void add_value(const std::string& line, std::size_t key_start, std::size_t key_end,
+                   std::size_t value_start, std::size_t value_end);
+};
+
+#endif /* _JSON_PROJECTOR_H_ */
@@ -29,6 +29,7 @@
 #include <stdexcept>
 
 #include <fcntl.h>
+#include <unistd.h>
 #include <errno.h>
 
 #include <kqueue.h>
@@ -48,24 +49,52 @@ Kqueue::Kqueue(const std::string& filename) :
 
     EV_SET(&change_, fd_, EVFILT_VNODE,
            EV_ADD | EV_ENABLE | EV_ONESHOT,
-           NOTE_EXTEND | NOTE_WRITE,
+           NOTE_EXTEND | NOTE_WRITE | NOTE_DELETE | NOTE_RENAME,
            0, 0);
 }
 
-void Kqueue::wait()
+void Kqueue::reopen()
+{
+    close(fd_);
+
+    // wait for the new file to show up, e.g. after log rotation
+    while ((fd_ = open(filename_.c_str(), O_RDONLY)) < 0) {
+        if (errno != ENOENT)
+            throw std::logic_error("open() failed");
+        usleep(100 * 1000);
+    }
+
+    EV_SET(&change_, fd_, EVFILT_VNODE,
+           EV_ADD | EV_ENABLE | EV_ONESHOT,
+           NOTE_EXTEND | NOTE_WRITE | NOTE_DELETE | NOTE_RENAME,
+           0, 0);
+}
+
+bool Kqueue::wait(std::chrono::steady_clock::time_point deadline)
 {
     struct kevent event;
 
     while (42) {
-        auto nev = kevent(kq_, &change_, 1, &event, 1, NULL);
+        auto timeout = wait_timeout(deadline);
+        struct timespec ts{ timeout / 1000, (timeout % 1000) * 1000000L };
+
+        auto nev = kevent(kq_, &change_, 1, &event, 1, timeout < 0 ? NULL : &ts);
         if (nev < 0) {
             if (errno == EINTR)
-                break;
+                return true;
             throw std::logic_error("kevent() failed");
         }
 
+        if (!nev)
+            return false;
+
+        if (event.fflags & NOTE_DELETE || event.fflags & NOTE_RENAME) {
+            reopen();
+            return true;
+        }
+
         if (event.fflags & NOTE_EXTEND || event.fflags & NOTE_WRITE)
-            break;
+            return true;
     }
 }
 
@@ -29,6 +29,7 @@
 
 #ifdef HAVE_KQUEUE
 
+#include <chrono>
 #include <string>
 
 #include <unistd.h>
@@ -46,12 +47,15 @@ public:
         close(fd_);
     }
 
-    virtual void wait() override;
+    // returns false if @deadline passed without changes
+    bool wait(std::chrono::steady_clock::time_point deadline);
 
 private:
     struct kevent change_;
     int fd_;
     int kq_;
+
+    void reopen();
 };
 
 #endif
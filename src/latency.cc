@@ -0,0 +1,58 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+
+#include <latency.h>
+
+void LatencyHistogram::reset()
+{
+    buckets_.fill(0);
+    count_ = 0;
+    max_ = 0;
+}
+
+LatencyHistogram::Duration LatencyHistogram::percentile(double p) const
+{
+    auto target = static_cast<std::uint64_t>(p / 100 * count_);
+    std::uint64_t seen = 0;
+
+    for (std::size_t i = 0; i < buckets_.size(); ++i) {
+        seen += buckets_[i];
+        if (seen > target)
+            return Duration(std::min(bucket_limit(i), max_));
+    }
+
+    return Duration(max_);
+}
+
+void LatencyHistogram::report(std::ostream& os) const
+{
+    using us = std::chrono::duration<double, std::micro>;
+
+    os << "notify to output latency: " << count_ << " lines"
+       << ", p50 " << us(percentile(50)).count() << " us"
+       << ", p99 " << us(percentile(99)).count() << " us"
+       << ", max " << us(Duration(max_)).count() << " us" << std::endl;
+}
@@ -0,0 +1,101 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _LATENCY_H_
+#define _LATENCY_H_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+// Histogram of latencies with log-linear buckets: 16 buckets per power of
+// two, i.e. values are accurate to about 6 %. Recording never allocates.
+class LatencyHistogram
+{
+public:
+    using Duration = std::chrono::nanoseconds;
+
+    LatencyHistogram()
+    {
+        reset();
+    }
+
+    virtual ~LatencyHistogram()
+    {}
+
+    void record(Duration latency)
+    {
+        auto ns = static_cast<std::uint64_t>(std::max<Duration::rep>(latency.count(), 0));
+
+        buckets_[bucket(ns)]++;
+        count_++;
+        if (ns > max_)
+            max_ = ns;
+    }
+
+    std::uint64_t count() const
+    {
+        return count_;
+    }
+
+    // upper bound of the bucket containing the @p percentile
+    Duration percentile(double p) const;
+
+    void report(std::ostream& os) const;
+
+    void reset();
+
+private:
+    static constexpr unsigned SUB_BITS = 4;
+    static constexpr unsigned SUB_BUCKETS = 1 << SUB_BITS;
+
+    std::array<std::uint64_t, 64 * SUB_BUCKETS> buckets_;
+    std::uint64_t count_;
+    std::uint64_t max_;
+
+    static std::size_t bucket(std::uint64_t ns)
+    {
+        if (ns < SUB_BUCKETS)
+            return ns;
+
+        unsigned exp = 63 - __builtin_clzll(ns);
+
+        return (exp - SUB_BITS + 1) * SUB_BUCKETS + ((ns >> (exp - SUB_BITS)) & (SUB_BUCKETS - 1));
+    }
+
+    static std::uint64_t bucket_limit(std::size_t idx)
+    {
+        if (idx < SUB_BUCKETS)
+            return idx;
+
+        unsigned exp = idx / SUB_BUCKETS + SUB_BITS - 1;
+        std::uint64_t sub = idx % SUB_BUCKETS;
+
+        return ((SUB_BUCKETS + sub + 1) << (exp - SUB_BITS)) - 1;
+    }
+};
+
+#endif /* _LATENCY_H_ */
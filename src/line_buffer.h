@@ -0,0 +1,112 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _LINE_BUFFER_H_
+#define _LINE_BUFFER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <circular_buffer.h>
+
+// A line along with the time the writer noticed its data.
+struct Line : public std::string
+{
+    using std::string::string;
+
+    Line(const std::string& str) :
+        std::string(str)
+    {}
+
+    // time the writer noticed the line
+    std::chrono::steady_clock::time_point stamp;
+};
+
+// Buffer of lines, which recycles lines consumed by the reader. That way the
+// writer reuses their memory instead of allocating new lines.
+class LineBuffer : public CircularBuffer<std::unique_ptr<Line>>
+{
+public:
+    LineBuffer(std::size_t size) :
+        CircularBuffer(size), limit_{size + IN_FLIGHT}
+    {
+        free_.reserve(limit_);
+    }
+
+    virtual ~LineBuffer()
+    {}
+
+    // fill the pool up front, so nothing is allocated later on
+    void preallocate(std::size_t line_size)
+    {
+        std::lock_guard lock(free_mutex_);
+
+        while (free_.size() < limit_) {
+            auto line = std::make_unique<Line>();
+
+            line->reserve(line_size);
+            free_.push_back(std::move(line));
+        }
+    }
+
+    std::unique_ptr<Line> allocate()
+    {
+        std::lock_guard lock(free_mutex_);
+
+        if (free_.empty())
+            return std::make_unique<Line>();
+
+        auto line = std::move(free_.back());
+        free_.pop_back();
+        line->clear();
+
+        return line;
+    }
+
+    void recycle(std::unique_ptr<Line> line)
+    {
+        std::lock_guard lock(free_mutex_);
+
+        // never grow the pool
+        if (free_.size() < limit_)
+            free_.push_back(std::move(line));
+    }
+
+private:
+    // besides a full buffer, the writer fills one line and the reader
+    // writes one line
+    static constexpr std::size_t IN_FLIGHT = 2;
+
+    std::size_t limit_;
+    std::mutex free_mutex_;
+    std::vector<std::unique_ptr<Line>> free_;
+};
+
+using KtailNGBuffer = LineBuffer;
+
+#endif /* _LINE_BUFFER_H_ */
@@ -0,0 +1,104 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <ktailng_config.h>
+
+#ifdef HAVE_LZ4
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include <lz4_compressor.h>
+
+namespace {
+
+// input is fed in pieces, so the output buffer has a fixed worst case size
+constexpr std::size_t INPUT_SIZE = 64 * 1024;
+
+}
+
+Lz4Compressor::Lz4Compressor() :
+    cctx_{nullptr}, prefs_{}, started_{false}
+{
+    if (LZ4F_isError(LZ4F_createCompressionContext(&cctx_, LZ4F_VERSION)))
+        throw std::logic_error("Failed to setup lz4");
+
+    prefs_.frameInfo.blockSizeID = LZ4F_max64KB;
+    prefs_.frameInfo.blockMode = LZ4F_blockLinked;
+
+    out_.resize(LZ4F_compressBound(INPUT_SIZE, &prefs_) + LZ4F_HEADER_SIZE_MAX);
+}
+
+Lz4Compressor::~Lz4Compressor()
+{
+    LZ4F_freeCompressionContext(cctx_);
+}
+
+void Lz4Compressor::emit(std::size_t ret)
+{
+    if (LZ4F_isError(ret))
+        throw std::logic_error("Compression failed");
+
+    std::cout.write(out_.data(), ret);
+}
+
+void Lz4Compressor::begin()
+{
+    if (started_)
+        return;
+
+    emit(LZ4F_compressBegin(cctx_, out_.data(), out_.size(), &prefs_));
+    started_ = true;
+}
+
+void Lz4Compressor::write(const char *data, std::size_t len)
+{
+    begin();
+
+    while (len) {
+        auto piece = std::min(len, INPUT_SIZE);
+
+        emit(LZ4F_compressUpdate(cctx_, out_.data(), out_.size(), data, piece, nullptr));
+        data += piece;
+        len -= piece;
+    }
+}
+
+void Lz4Compressor::flush()
+{
+    begin();
+    emit(LZ4F_flush(cctx_, out_.data(), out_.size(), nullptr));
+    std::cout.flush();
+}
+
+void Lz4Compressor::finish()
+{
+    begin();
+    emit(LZ4F_compressEnd(cctx_, out_.data(), out_.size(), nullptr));
+    std::cout.flush();
+    started_ = false;
+}
+
+#endif
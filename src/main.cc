@@ -22,16 +22,30 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <cctype>
+#include <chrono>
 #include <cstdlib>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <stdexcept>
+#include <vector>
 
-#include <circular_buffer.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include <line_buffer.h>
 #include <reader.h>
 #include <writer.h>
+#include <glob_writer.h>
+#include <filter.h>
+#include <page_cache.h>
+#include <compressed_file.h>
 #include <barrier.h>
 #include <ktailng_config.h>
 
@@ -54,15 +68,81 @@ void print_version_and_die()
     std::exit(EXIT_SUCCESS);
 }
 
+// parses a decimal number, which has to make up the whole string
+static std::size_t to_number(const std::string& str, const char *error)
+{
+    std::size_t pos = 0, value = 0;
+
+    if (str.empty() || !std::isdigit(static_cast<unsigned char>(str[0])))
+        throw std::logic_error(error);
+
+    try {
+        value = std::stoul(str, &pos);
+    } catch (const std::exception&) {
+        throw std::logic_error(error);
+    }
+
+    if (pos != str.size())
+        throw std::logic_error(error);
+
+    return value;
+}
+
+static void pin_thread(std::thread& thread, int cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    if (pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set))
+        std::cerr << "Warning: Failed to pin thread to CPU " << cpu << std::endl;
+#else
+    std::cerr << "Warning: Pinning threads is not supported" << std::endl;
+#endif
+}
+
+template<typename W, typename R>
+static void run(W& writer, R& reader, const std::vector<int>& cpus)
+{
+    std::thread writer_thread(std::bind(&W::write, &writer));
+    std::thread reader_thread(std::bind(&R::read, &reader));
+
+    if (!cpus.empty()) {
+        pin_thread(writer_thread, cpus[0]);
+        pin_thread(reader_thread, cpus[1]);
+    }
+
+    writer_thread.join();
+    reader_thread.join();
+}
+
 int main(int argc, char *argv[])
 {
     Kopt::OptionParser parser{argc, argv};
-    std::size_t num;
+    std::size_t num, max_open;
+    FilterOptions filter;
+    PageCache::Mode cache = PageCache::Mode::NORMAL;
+    std::chrono::microseconds spin{0};
+    std::vector<int> cpus;
 
     // arguments
     parser.add_flag_option("help", "print this help text", 'h');
     parser.add_flag_option("follow", "follow changes", 'f');
     parser.add_argument_option("number", "show last <lines> lines", 'n');
+    parser.add_argument_option("glob", "show files matching <pattern>", 'g');
+    parser.add_flag_option("collapse", "collapse repeated lines", 'C');
+    parser.add_argument_option("compress", "compress output by <algorithm>", 'c');
+    parser.add_argument_option("index", "cache gzip index in <file>", 'i');
+    parser.add_flag_option("nocache", "drop read data from the page cache", 'N');
+    parser.add_flag_option("direct", "bypass the page cache for the initial scan", 'D');
+    parser.add_flag_option("low-latency", "busy poll for new lines (follow)", 'L');
+    parser.add_argument_option("cpus", "pin writer and reader to <cpu,cpu>", 'P');
+    parser.add_argument_option("sample", "show only every <1/n>-th line", 's');
+    parser.add_argument_option("max-rate", "show at most <lines> lines per second", 'r');
+    parser.add_argument_option("fields", "show only JSON <fields> (comma separated)", 'F');
+    parser.add_argument_option("max-open", "keep at most <files> files open (glob)", 'm');
     parser.add_flag_option("version", "print version information", 'v');
 
     try {
@@ -73,33 +153,125 @@ int main(int argc, char *argv[])
         if (*parser["help"])
             print_usage_and_die(parser, 0);
 
-        if (parser.unparsed_options().size() != 1)
+        if (*parser["glob"]) {
+            if (parser.unparsed_options().size() != 0)
+                throw std::logic_error("Files and glob pattern given.");
+        } else if (parser.unparsed_options().size() != 1)
             throw std::logic_error("No or too many files given.");
 
+        // glob mode reads all files through the same plain path
+        if (*parser["glob"] &&
+            (*parser["low-latency"] || *parser["cpus"] || *parser["direct"] ||
+             *parser["nocache"] || *parser["index"]))
+            throw std::logic_error("Option not supported in glob mode.");
+
+        // compressed files are read through the decompressor only
+        if (!*parser["glob"] && (*parser["direct"] || *parser["nocache"]) &&
+            CompressedFile::format(parser.unparsed_options()[0]) != CompressedFile::Format::NONE)
+            throw std::logic_error("Option not supported for compressed files.");
+
         if (*parser["number"])
             num = parser["number"]->to<std::size_t>();
         else
             num = 1000;
+
+        if (*parser["max-open"])
+            max_open = parser["max-open"]->to<std::size_t>();
+        else
+            max_open = 256;
+
+        filter.collapse = *parser["collapse"];
+
+        if (*parser["direct"])
+            cache = PageCache::Mode::DIRECT;
+        else if (*parser["nocache"])
+            cache = PageCache::Mode::DROP;
+
+        if (*parser["sample"]) {
+            auto sample = parser["sample"]->to<std::string>();
+
+            // accept both 1/n and n
+            if (sample.rfind("1/", 0) == 0)
+                sample.erase(0, 2);
+            filter.sample = to_number(sample, "Invalid sample rate.");
+            if (!filter.sample)
+                throw std::logic_error("Invalid sample rate.");
+        }
+
+        if (*parser["fields"]) {
+            std::istringstream fields(parser["fields"]->to<std::string>());
+            std::string field;
+
+            while (std::getline(fields, field, ','))
+                if (!field.empty())
+                    filter.fields.push_back(field);
+            if (filter.fields.empty())
+                throw std::logic_error("No fields given.");
+        }
+
+        if (*parser["max-rate"]) {
+            filter.max_rate = parser["max-rate"]->to<double>();
+            if (filter.max_rate <= 0)
+                throw std::logic_error("Invalid maximum rate.");
+        }
+
+        if (*parser["low-latency"]) {
+            if (!*parser["follow"])
+                throw std::logic_error("Low latency mode requires follow mode.");
+            spin = std::chrono::microseconds(200);
+        }
+
+        if (*parser["cpus"]) {
+            std::istringstream list(parser["cpus"]->to<std::string>());
+            std::string cpu;
+
+            while (std::getline(list, cpu, ','))
+                cpus.push_back(static_cast<int>(to_number(cpu, "Invalid CPU list.")));
+            if (cpus.size() != 2)
+                throw std::logic_error("Two CPUs expected.");
+        }
     } catch (const std::exception& ex) {
         std::cerr << "Error: " << ex.what() << std::endl;
         print_usage_and_die(parser, 1);
     }
 
-    auto&& file = parser.unparsed_options()[0];
-
     // let's go
     try {
         KtailNGBuffer buf(num);
         KtailNGBarrier barrier;
 
-        Writer writer(buf, barrier, file, *parser["follow"]);
-        Reader reader(buf, barrier, *parser["follow"]);
+        // no allocations on the hot path
+        if (spin.count())
+            buf.preallocate(512);
+
+        auto compress = *parser["compress"] ? parser["compress"]->to<std::string>() : "";
+        auto follow = *parser["follow"];
+
+        // choose the pipeline once, nothing is decided per line later on
+        dispatch_filter(filter, [&](auto filter_type) {
+            using Filter = typename decltype(filter_type)::type;
+
+            dispatch_reader(!compress.empty(), spin.count(), [&](auto reader_type) {
+                using Reader = typename decltype(reader_type)::type;
+
+                Reader reader(buf, barrier, follow, compress, spin);
+
+                if (*parser["glob"]) {
+                    auto pattern = parser["glob"]->to<std::string>();
+                    GlobWriter<Filter> writer(buf, barrier, pattern, follow,
+                                              max_open, filter);
 
-        std::thread writer_thread(std::bind(&Writer::write, &writer));
-        std::thread reader_thread(std::bind(&Reader::read, &reader));
+                    run(writer, reader, cpus);
+                } else {
+                    auto&& file = parser.unparsed_options()[0];
+                    auto index = *parser["index"] ? parser["index"]->to<std::string>() : "";
+                    Writer<Filter> writer(buf, barrier, file, follow, index,
+                                          filter, cache, spin);
 
-        writer_thread.join();
-        reader_thread.join();
+                    run(writer, reader, cpus);
+                }
+            });
+        });
     } catch (const std::exception& ex) {
         std::cerr << "Error: " << ex.what() << std::endl;
         return EXIT_FAILURE;
@@ -25,8 +25,25 @@
 #ifndef _METHOD_H_
 #define _METHOD_H_
 
+#include <algorithm>
+#include <chrono>
 #include <string>
 
+// The notification mechanisms wait until @deadline at most. This returns the
+// time left in milliseconds, or -1 for no deadline.
+inline int wait_timeout(std::chrono::steady_clock::time_point deadline)
+{
+    if (deadline == std::chrono::steady_clock::time_point::max())
+        return -1;
+
+    auto left = std::chrono::ceil<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+
+    return static_cast<int>(std::max<std::chrono::milliseconds::rep>(left.count(), 0));
+}
+
+// Common part of the notification mechanisms. Those are selected at compile
+// time, so wait() is not part of this interface.
 class Method
 {
 public:
@@ -37,8 +54,6 @@ public:
     virtual ~Method()
     {}
 
-    virtual void wait() = 0;
-
 protected:
     std::string filename_;
 };
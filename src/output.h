@@ -0,0 +1,86 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _OUTPUT_H_
+#define _OUTPUT_H_
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <compressor.h>
+
+// Where the Reader puts lines. These are policies of the Reader, so writing
+// plain text doesn't go through the Compressor interface for every line.
+
+class PlainOutput
+{
+public:
+    PlainOutput(const std::string&)
+    {}
+
+    void write(const std::string& line)
+    {
+        std::cout << line << '\n';
+    }
+
+    void flush()
+    {
+        std::cout.flush();
+    }
+
+    void finish()
+    {
+        std::cout.flush();
+    }
+};
+
+class CompressedOutput
+{
+public:
+    CompressedOutput(const std::string& algorithm) :
+        compressor_{Compressor::create(algorithm)}
+    {}
+
+    void write(const std::string& line)
+    {
+        compressor_->write(line.data(), line.size());
+        compressor_->write("\n", 1);
+    }
+
+    void flush()
+    {
+        compressor_->flush();
+    }
+
+    void finish()
+    {
+        compressor_->finish();
+    }
+
+private:
+    std::unique_ptr<Compressor> compressor_;
+};
+
+#endif /* _OUTPUT_H_ */
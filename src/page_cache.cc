@@ -0,0 +1,89 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <page_cache.h>
+#include <ktailng_config.h>
+
+namespace {
+
+// amount of data read ahead, the advice is renewed every half window
+constexpr off_t WINDOW_SIZE = 4 * 1024 * 1024;
+
+}
+
+PageCache::PageCache(const std::string& filename, Mode mode) :
+    filename_{filename}, mode_{mode}, fd_{-1}, dropped_{0}, next_{0}
+{
+    if (mode_ == Mode::NORMAL)
+        return;
+
+    // WILLNEED and DONTNEED act on the file's pages, so any descriptor will
+    // do. Readahead hints like SEQUENTIAL would not reach the reading stream.
+    fd_ = open(filename_.c_str(), O_RDONLY);
+    if (fd_ < 0)
+        throw std::logic_error("open() failed");
+}
+
+PageCache::~PageCache()
+{
+    if (fd_ >= 0)
+        close(fd_);
+}
+
+void PageCache::reset()
+{
+    if (mode_ == Mode::NORMAL)
+        return;
+
+    close(fd_);
+    fd_ = open(filename_.c_str(), O_RDONLY);
+    if (fd_ < 0)
+        throw std::logic_error("open() failed");
+
+    dropped_ = 0;
+    next_ = 0;
+}
+
+void PageCache::advise_range(off_t pos)
+{
+    // without advice (e.g. on macOS) dropping pages is not possible
+#ifdef HAVE_POSIX_FADVISE
+    auto page = sysconf(_SC_PAGESIZE);
+    auto consumed = pos / page * page;
+
+    posix_fadvise(fd_, pos, WINDOW_SIZE, POSIX_FADV_WILLNEED);
+
+    if (consumed > dropped_) {
+        posix_fadvise(fd_, dropped_, consumed - dropped_, POSIX_FADV_DONTNEED);
+        dropped_ = consumed;
+    }
+#endif
+
+    next_ = pos + WINDOW_SIZE / 2;
+}
@@ -0,0 +1,74 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _PAGE_CACHE_H_
+#define _PAGE_CACHE_H_
+
+#include <cstdint>
+#include <string>
+
+#include <sys/types.h>
+
+// Keeps reading large files from evicting other data from the page cache:
+// the range ahead of the current position is read ahead asynchronously, and
+// the pages behind it are dropped once consumed.
+class PageCache
+{
+public:
+    enum class Mode {
+        NORMAL,                 // leave it to the kernel
+        DROP,                   // read ahead and drop behind
+        DIRECT,                 // like DROP, initial scan bypasses the cache
+    };
+
+    PageCache(const std::string& filename, Mode mode);
+
+    virtual ~PageCache();
+
+    Mode mode() const
+    {
+        return mode_;
+    }
+
+    // called for each position reached while reading
+    void advise(off_t pos)
+    {
+        if (mode_ != Mode::NORMAL && pos >= next_)
+            advise_range(pos);
+    }
+
+    // file was truncated or replaced
+    void reset();
+
+private:
+    std::string filename_;
+    Mode mode_;
+    int fd_;
+    off_t dropped_;
+    off_t next_;
+
+    void advise_range(off_t pos);
+};
+
+#endif /* _PAGE_CACHE_H_ */
@@ -22,16 +22,27 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <chrono>
 #include <iostream>
+#include <memory>
+#include <string>
 
-#include <circular_buffer.h>
+#include <line_buffer.h>
 #include <barrier.h>
+#include <latency.h>
+#include <output.h>
+#include <type_list.h>
 
+// Writes lines to the Output. In LowLatency mode every line is flushed right
+// away and its latency is reported, otherwise output is batched.
+template<typename Output, bool LowLatency>
 class Reader
 {
 public:
-    Reader(KtailNGBuffer& buffer, KtailNGBarrier& barrier, bool follow) :
-        buffer_{buffer}, barrier_{barrier}, follow_{follow}
+    Reader(KtailNGBuffer& buffer, KtailNGBarrier& barrier, bool follow,
+           const std::string& compress, std::chrono::microseconds spin) :
+        buffer_{buffer}, barrier_{barrier}, follow_{follow},
+        output_{compress}, spin_{spin}
     {}
 
     virtual ~Reader()
@@ -41,16 +52,100 @@ public:
     {
         // wait for writer
         barrier_.arrive();
+        start_ = last_report_ = std::chrono::steady_clock::now();
 
         // go
         follow_ ? read_follow() : read_no_follow();
     }
 
 private:
+    static constexpr std::chrono::seconds REPORT_INTERVAL{10};
+
     KtailNGBuffer& buffer_;
     KtailNGBarrier& barrier_;
     bool follow_;
+    Output output_;
+    std::chrono::microseconds spin_;
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::time_point last_report_;
+    LatencyHistogram latency_;
 
     void read_follow();
     void read_no_follow();
+    void account(const Line& line);
 };
+
+template<typename Output, bool LowLatency>
+void Reader<Output, LowLatency>::account(const Line& line)
+{
+    auto now = std::chrono::steady_clock::now();
+
+    // lines of the initial tail don't count
+    if (line.stamp >= start_)
+        latency_.record(now - line.stamp);
+
+    if (now - last_report_ >= REPORT_INTERVAL) {
+        latency_.report(std::cerr);
+        latency_.reset();
+        last_report_ = now;
+    }
+}
+
+template<typename Output, bool LowLatency>
+void Reader<Output, LowLatency>::read_follow()
+{
+    while (42) {
+        auto line = buffer_.try_pop();
+
+        // flush only when idle, so bursts are batched
+        if (!line) {
+            output_.flush();
+            if constexpr (LowLatency)
+                line = buffer_.pop_spin(spin_);
+            else
+                line = buffer_.pop();
+        }
+
+        output_.write(*line);
+
+        // low latency: no batching at all
+        if constexpr (LowLatency) {
+            output_.flush();
+            account(*line);
+        }
+
+        buffer_.recycle(std::move(line));
+    }
+}
+
+template<typename Output, bool LowLatency>
+void Reader<Output, LowLatency>::read_no_follow()
+{
+    while (42) {
+        auto line = buffer_.try_pop();
+
+        if (!line)
+            break;
+
+        output_.write(*line);
+    }
+
+    output_.finish();
+}
+
+// Calls @f with TypeTag<Reader<...>> matching the output options.
+template<typename F>
+void dispatch_reader(bool compress, bool low_latency, F&& f)
+{
+    if (compress) {
+        if (low_latency)
+            f(TypeTag<Reader<CompressedOutput, true>>{});
+        else
+            f(TypeTag<Reader<CompressedOutput, false>>{});
+    } else {
+        if (low_latency)
+            f(TypeTag<Reader<PlainOutput, true>>{});
+        else
+            f(TypeTag<Reader<PlainOutput, false>>{});
+    }
+}
@@ -0,0 +1,82 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <functional>
+#include <string_view>
+
+#include <stages.h>
+
+void RateLimit::refill()
+{
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = now - last_refill_;
+
+    // bursts of up to one second worth of lines are fine, but at least one
+    // line has to fit for rates below one line per second
+    tokens_ = std::min(std::max(rate_, 1.0), tokens_ + elapsed.count() * rate_);
+    last_refill_ = now;
+}
+
+void RateLimit::idle()
+{
+    if (!dropped_)
+        return;
+
+    sink_.push(std::make_unique<Line>(
+                   "[dropped " + std::to_string(dropped_) +
+                   (dropped_ == 1 ? " line]" : " lines]")));
+    dropped_ = 0;
+}
+
+void Collapse::flush_repeated()
+{
+    if (!repeated_)
+        return;
+
+    sink_.push(std::make_unique<Line>(
+                   "[repeated " + std::to_string(repeated_) +
+                   (repeated_ == 1 ? " time]" : " times]")));
+    repeated_ = 0;
+}
+
+bool Collapse::process(Line& line)
+{
+    auto hash = std::hash<std::string_view>{}(line);
+
+    // same as the previous line?
+    if (has_last_ && hash == last_hash_ && line == last_) {
+        if (!repeated_++)
+            since_ = std::chrono::steady_clock::now();
+        return false;
+    }
+
+    flush_repeated();
+
+    has_last_ = true;
+    last_hash_ = hash;
+    last_ = line;
+
+    return true;
+}
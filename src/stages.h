@@ -0,0 +1,288 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _STAGES_H_
+#define _STAGES_H_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <line_buffer.h>
+#include <json_projector.h>
+
+struct FilterOptions {
+    bool collapse = false;
+    std::size_t sample = 0;
+    double max_rate = 0;
+    std::vector<std::string> fields;
+};
+
+// End of the filter: lines are pushed into the buffer. Overwriting the oldest
+// lines is fine for the initial tail, but must not happen when following.
+class Sink
+{
+public:
+    Sink(KtailNGBuffer& buffer) :
+        buffer_{buffer}, following_{false}
+    {}
+
+    void push(std::unique_ptr<Line> line)
+    {
+        if (following_)
+            buffer_.push_wait(std::move(line));
+        else
+            buffer_.push(std::move(line));
+    }
+
+    void recycle(std::unique_ptr<Line> line)
+    {
+        buffer_.recycle(std::move(line));
+    }
+
+    void follow()
+    {
+        following_ = true;
+    }
+
+private:
+    KtailNGBuffer& buffer_;
+    bool following_;
+};
+
+// Stages are policies of the Filter. Each one hides the parts of this no-op
+// stage it cares about:
+//  - admit(): decides whether the next line is kept, before it is read
+//  - retry(): the line was incomplete, undo the last admit()
+//  - process(): modifies the line or drops it (returns false)
+//  - idle(): the writer has consumed all available data
+//  - deadline(): when idle() is due at the latest, even without new data
+//  - follow(): the initial tail is done
+class Stage
+{
+public:
+    bool admit()
+    {
+        return true;
+    }
+
+    void retry()
+    {}
+
+    bool process(Line&)
+    {
+        return true;
+    }
+
+    void idle()
+    {}
+
+    std::chrono::steady_clock::time_point deadline() const
+    {
+        return std::chrono::steady_clock::time_point::max();
+    }
+
+    void follow()
+    {}
+};
+
+// keeps every n-th line
+class Sample : public Stage
+{
+public:
+    Sample(Sink&, const FilterOptions& options) :
+        sample_{options.sample}, count_{0}
+    {}
+
+    static bool enabled(const FilterOptions& options)
+    {
+        return options.sample > 1;
+    }
+
+    bool admit()
+    {
+        auto keep = !count_;
+
+        if (++count_ == sample_)
+            count_ = 0;
+
+        return keep;
+    }
+
+    void retry()
+    {
+        count_ = count_ ? count_ - 1 : sample_ - 1;
+    }
+
+private:
+    std::size_t sample_;
+    std::size_t count_;
+};
+
+// token bucket, applies to new lines only, not the initial tail
+class RateLimit : public Stage
+{
+public:
+    RateLimit(Sink& sink, const FilterOptions& options) :
+        sink_{sink}, rate_{options.max_rate}, tokens_{options.max_rate},
+        last_refill_{std::chrono::steady_clock::now()}, active_{false},
+        admitted_{true}, dropped_{0}
+    {}
+
+    static bool enabled(const FilterOptions& options)
+    {
+        return options.max_rate > 0;
+    }
+
+    bool admit()
+    {
+        if (!active_)
+            return true;
+
+        if (tokens_ < 1)
+            refill();
+
+        admitted_ = tokens_ >= 1;
+        if (admitted_)
+            tokens_--;
+        else
+            dropped_++;
+
+        return admitted_;
+    }
+
+    void retry()
+    {
+        if (!active_)
+            return;
+
+        if (admitted_)
+            tokens_++;
+        else
+            dropped_--;
+    }
+
+    void idle();
+
+    void follow()
+    {
+        active_ = true;
+        last_refill_ = std::chrono::steady_clock::now();
+    }
+
+private:
+    Sink& sink_;
+    double rate_;
+    double tokens_;
+    std::chrono::steady_clock::time_point last_refill_;
+    bool active_;
+    bool admitted_;
+    std::size_t dropped_;
+
+    void refill();
+};
+
+// reduces JSON objects to some top level fields
+class Project : public Stage
+{
+public:
+    Project(Sink&, const FilterOptions& options) :
+        projector_{options.fields}
+    {}
+
+    static bool enabled(const FilterOptions& options)
+    {
+        return !options.fields.empty();
+    }
+
+    bool process(Line& line)
+    {
+        if (!projector_.project(line, projected_))
+            return false;
+
+        // keep the original line's memory for the next projection
+        line.swap(projected_);
+
+        return true;
+    }
+
+private:
+    JsonProjector projector_;
+    std::string projected_;
+};
+
+// suppresses consecutive duplicates
+class Collapse : public Stage
+{
+public:
+    Collapse(Sink& sink, const FilterOptions&) :
+        sink_{sink}, has_last_{false}, last_hash_{0}, repeated_{0},
+        following_{false}
+    {}
+
+    static bool enabled(const FilterOptions& options)
+    {
+        return options.collapse;
+    }
+
+    bool process(Line& line);
+
+    // While following, a run usually spans many wakeups. Report it once it
+    // ended or lasted long enough, not on each wakeup.
+    void idle()
+    {
+        if (!following_ || std::chrono::steady_clock::now() >= deadline())
+            flush_repeated();
+    }
+
+    std::chrono::steady_clock::time_point deadline() const
+    {
+        if (!following_ || !repeated_)
+            return std::chrono::steady_clock::time_point::max();
+
+        return since_ + FLUSH_INTERVAL;
+    }
+
+    void follow()
+    {
+        following_ = true;
+    }
+
+private:
+    static constexpr std::chrono::seconds FLUSH_INTERVAL{1};
+
+    Sink& sink_;
+    bool has_last_;
+    std::string last_;
+    std::size_t last_hash_;
+    std::size_t repeated_;
+    std::chrono::steady_clock::time_point since_;
+    bool following_;
+
+    void flush_repeated();
+};
+
+#endif /* _STAGES_H_ */
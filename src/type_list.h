@@ -22,25 +22,20 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
-#include <reader.h>
+#ifndef _TYPE_LIST_H_
+#define _TYPE_LIST_H_
 
-void Reader::read_follow()
-{
-    while (42) {
-        auto line = buffer_.pop();
+// Helpers for selecting template instantiations at runtime.
 
-        std::cout << *line << std::endl;
-    }
-}
+template<typename... Ts>
+struct TypeList
+{};
 
-void Reader::read_no_follow()
+// passes a type to generic lambdas
+template<typename T>
+struct TypeTag
 {
-    while (42) {
-        auto line = buffer_.try_pop();
-
-        if (!line)
-            return;
+    using type = T;
+};
 
-        std::cout << *line << std::endl;
-    }
-}
+#endif /* _TYPE_LIST_H_ */
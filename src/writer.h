@@ -22,24 +22,47 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <chrono>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <limits>
 #include <memory>
+#include <stdexcept>
+#include <cerrno>
 
-#include <circular_buffer.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <line_buffer.h>
 #include <barrier.h>
 #include <filesystem_watcher.h>
+#include <compressed_file.h>
+#include <filter.h>
+#include <page_cache.h>
 
+// Tails one file. The filter and the notification mechanism are template
+// parameters, so neither costs a virtual call per line or wake up.
+template<typename Filter, typename Watcher = FilesystemWatcher>
 class Writer
 {
 public:
     Writer(KtailNGBuffer& buffer, KtailNGBarrier& barrier,
-           const std::string& filename, bool follow) :
+           const std::string& filename, bool follow,
+           const std::string& index, const FilterOptions& filter,
+           PageCache::Mode cache, std::chrono::microseconds spin) :
         buffer_{buffer}, barrier_{barrier}, filename_{filename}, follow_{follow},
-        pos_{0}, watcher_{filename}
-    {}
+        pos_{0}, inode_{0}, size_{0}, spin_{spin}, watcher_{filename}, compressed_{CompressedFile::open(filename, index)},
+        filter_{buffer, filter}, cache_{filename, cache}
+    {
+        if (compressed_ && follow_)
+            throw std::logic_error("Compressed files cannot be followed");
+    }
 
     virtual ~Writer()
     {}
@@ -51,8 +74,260 @@ private:
     KtailNGBarrier& barrier_;
     std::string filename_;
     bool follow_;
+    std::ifstream ifs_;
     std::ifstream::pos_type pos_;
-    FilesystemWatcher watcher_;
+    ino_t inode_;
+    off_t size_;
+    std::chrono::microseconds spin_;
+    std::chrono::steady_clock::time_point notified_;  // change was noticed
+    Watcher watcher_;
+    std::unique_ptr<CompressedFile> compressed_;
+    Filter filter_;
+    PageCache cache_;
 
+    bool poll();
     void read();
+    void read_lines(std::chrono::steady_clock::time_point stamp);
+    void read_direct();
+    void read_compressed();
 };
+
+template<typename Filter, typename Watcher>
+bool Writer<Filter, Watcher>::poll()
+{
+    auto deadline = std::chrono::steady_clock::now() + spin_;
+    struct stat st;
+
+    // busy poll for new data, before going to sleep
+    do {
+        if (!stat(filename_.c_str(), &st) &&
+            (st.st_ino != inode_ || st.st_size != size_))
+            return true;
+    } while (std::chrono::steady_clock::now() < deadline);
+
+    return false;
+}
+
+template<typename Filter, typename Watcher>
+void Writer<Filter, Watcher>::read()
+{
+    struct stat st;
+
+    // file is being replaced, wait for the new one
+    if (stat(filename_.c_str(), &st)) {
+        if (inode_ && errno == ENOENT)
+            return;
+        throw std::logic_error("Failed to stat file");
+    }
+
+    auto stamp = notified_;
+
+    // a rotated file may still hold lines written before the rename, which
+    // haven't been read yet, e.g. because the writer was slow to wake up
+    if (inode_ && st.st_ino != inode_ && ifs_.is_open())
+        read_lines(stamp);
+
+    // start over on new (rotated) or truncated files
+    if ((inode_ && st.st_ino != inode_) || st.st_size < static_cast<std::streamoff>(pos_)) {
+        pos_ = 0;
+        cache_.reset();
+    }
+
+    // keep the file open, unless it has been replaced
+    if (!ifs_.is_open() || st.st_ino != inode_) {
+        ifs_.close();
+        ifs_.open(filename_);
+        if (!ifs_)
+            throw std::logic_error("Failed to open file");
+    }
+    inode_ = st.st_ino;
+    size_ = st.st_size;
+
+    read_lines(stamp);
+
+    filter_.idle();
+}
+
+// reads all complete lines of the open file from pos_ on
+template<typename Filter, typename Watcher>
+void Writer<Filter, Watcher>::read_lines(std::chrono::steady_clock::time_point stamp)
+{
+    auto& ifs = ifs_;
+    auto old_pos = pos_, pos = pos_;
+
+    ifs.clear();
+    ifs.seekg(pos_);
+
+    // read file
+    while (42) {
+        // skip dropped lines without reading them into memory
+        if (!filter_.admit()) {
+            ifs.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+            old_pos = pos;
+            pos = ifs.tellg();
+
+            if (ifs.eof()) {
+                filter_.retry();
+                break;
+            }
+
+            if (ifs.bad() || ifs.fail())
+                throw std::logic_error("I/O error while reading file");
+
+            continue;
+        }
+
+        auto line = buffer_.allocate();
+
+        std::getline(ifs, *line);
+        line->stamp = stamp;
+
+        old_pos = pos;
+        pos = ifs.tellg();
+
+        if (ifs.eof()) {
+            filter_.retry();
+            buffer_.recycle(std::move(line));
+            break;
+        }
+
+        if (ifs.bad() || ifs.fail())
+            throw std::logic_error("I/O error while reading file");
+
+        filter_.push(std::move(line));
+        cache_.advise(pos);
+    }
+
+    pos_ = old_pos;
+}
+
+template<typename Filter, typename Watcher>
+void Writer<Filter, Watcher>::read_direct()
+{
+    constexpr std::size_t BUFFER_SIZE = 1024 * 1024;
+    constexpr std::size_t ALIGNMENT = 4096;
+    std::unique_ptr<char, decltype(&std::free)> buffer{nullptr, &std::free};
+    off_t offset = 0, line_start = 0;
+    std::string carry;
+    struct stat st;
+    void *mem;
+
+#ifdef O_DIRECT
+    auto fd = open(filename_.c_str(), O_RDONLY | O_DIRECT);
+#else
+    auto fd = -1;
+    errno = EINVAL;
+#endif
+    if (fd < 0) {
+        // not supported by all filesystems
+        if (errno == EINVAL)
+            return read();
+        throw std::logic_error("Failed to open file");
+    }
+
+    if (fstat(fd, &st) || posix_memalign(&mem, ALIGNMENT, BUFFER_SIZE)) {
+        close(fd);
+        throw std::logic_error("Failed to setup direct I/O");
+    }
+    buffer.reset(static_cast<char *>(mem));
+    inode_ = st.st_ino;
+    size_ = st.st_size;
+
+    while (42) {
+        auto rc = ::read(fd, buffer.get(), BUFFER_SIZE);
+        if (rc < 0) {
+            if (errno == EINTR)
+                continue;
+            close(fd);
+            if (errno == EINVAL && !offset)
+                return read();
+            throw std::logic_error("I/O error while reading file");
+        }
+
+        if (!rc)
+            break;
+
+        // split lines, dropped ones are never copied
+        for (const char *ptr = buffer.get(), *end = ptr + rc; ptr < end; ) {
+            auto *newline = static_cast<const char *>(std::memchr(ptr, '\n', end - ptr));
+
+            if (!newline) {
+                carry.append(ptr, end);
+                break;
+            }
+
+            if (filter_.admit()) {
+                auto line = buffer_.allocate();
+
+                line->append(carry).append(ptr, newline);
+                filter_.push(std::move(line));
+            }
+
+            carry.clear();
+            line_start = offset + (newline + 1 - buffer.get());
+            ptr = newline + 1;
+        }
+
+        offset += rc;
+    }
+
+    close(fd);
+
+    // incomplete last line is read again later
+    pos_ = line_start;
+
+    filter_.idle();
+}
+
+template<typename Filter, typename Watcher>
+void Writer<Filter, Watcher>::read_compressed()
+{
+    auto data = compressed_->tail(buffer_.size());
+    std::size_t start = 0;
+
+    while (start < data.size()) {
+        auto end = data.find('\n', start);
+
+        if (end == std::string::npos)
+            end = data.size();
+
+        if (filter_.admit()) {
+            auto line = buffer_.allocate();
+
+            line->assign(data, start, end - start);
+            filter_.push(std::move(line));
+        }
+        start = end + 1;
+    }
+
+    filter_.idle();
+}
+
+template<typename Filter, typename Watcher>
+void Writer<Filter, Watcher>::write()
+{
+    if (compressed_)
+        read_compressed();
+    else if (cache_.mode() == PageCache::Mode::DIRECT)
+        read_direct();
+    else
+        read();
+
+    barrier_.arrive();
+
+    if (!follow_)
+        return;
+
+    filter_.follow();
+
+    while (42) {
+        // nothing new until the filter's deadline: let it flush
+        if ((!spin_.count() || !poll()) && !watcher_.wait(filter_.deadline())) {
+            filter_.idle();
+            continue;
+        }
+        notified_ = std::chrono::steady_clock::now();
+        read();
+    }
+}
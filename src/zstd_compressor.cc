@@ -0,0 +1,79 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <ktailng_config.h>
+
+#ifdef HAVE_ZSTD
+
+#include <iostream>
+#include <stdexcept>
+
+#include <zstd_compressor.h>
+
+ZstdCompressor::ZstdCompressor() :
+    cctx_{ZSTD_createCCtx()}, out_(ZSTD_CStreamOutSize())
+{
+    if (!cctx_)
+        throw std::logic_error("Failed to setup zstd");
+}
+
+ZstdCompressor::~ZstdCompressor()
+{
+    ZSTD_freeCCtx(cctx_);
+}
+
+void ZstdCompressor::compress(const char *data, std::size_t len, ZSTD_EndDirective mode)
+{
+    ZSTD_inBuffer in{ data, len, 0 };
+    std::size_t remaining;
+
+    do {
+        ZSTD_outBuffer out{ out_.data(), out_.size(), 0 };
+
+        remaining = ZSTD_compressStream2(cctx_, &out, &in, mode);
+        if (ZSTD_isError(remaining))
+            throw std::logic_error("Compression failed");
+
+        std::cout.write(out_.data(), out.pos);
+    } while (mode == ZSTD_e_continue ? in.pos < in.size : remaining);
+}
+
+void ZstdCompressor::write(const char *data, std::size_t len)
+{
+    compress(data, len, ZSTD_e_continue);
+}
+
+void ZstdCompressor::flush()
+{
+    compress(nullptr, 0, ZSTD_e_flush);
+    std::cout.flush();
+}
+
+void ZstdCompressor::finish()
+{
+    compress(nullptr, 0, ZSTD_e_end);
+    std::cout.flush();
+}
+
+#endif
@@ -0,0 +1,58 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _ZSTD_COMPRESSOR_H_
+#define _ZSTD_COMPRESSOR_H_
+
+#include <ktailng_config.h>
+
+#ifdef HAVE_ZSTD
+
+#include <vector>
+
+#include <zstd.h>
+
+#include <compressor.h>
+
+class ZstdCompressor : public Compressor
+{
+public:
+    ZstdCompressor();
+
+    virtual ~ZstdCompressor();
+
+    virtual void write(const char *data, std::size_t len) override;
+    virtual void flush() override;
+    virtual void finish() override;
+
+private:
+    ZSTD_CCtx *cctx_;
+    std::vector<char> out_;
+
+    void compress(const char *data, std::size_t len, ZSTD_EndDirective mode);
+};
+
+#endif
+
+#endif /* _ZSTD_COMPRESSOR_H_ */
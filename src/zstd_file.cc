@@ -0,0 +1,126 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <ktailng_config.h>
+
+#ifdef HAVE_ZSTD
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <zstd_file.h>
+
+namespace {
+
+constexpr std::size_t TRIM_SIZE = 4 * 1024 * 1024;
+
+}
+
+ZstdFile::ZstdFile(const std::string& filename) :
+    CompressedFile(filename), data_{nullptr}, size_{0}, dctx_{nullptr}
+{
+    struct stat st;
+    void *map;
+
+    auto fd = ::open(filename_.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::logic_error("open() failed");
+
+    if (fstat(fd, &st)) {
+        close(fd);
+        throw std::logic_error("fstat() failed");
+    }
+
+    size_ = st.st_size;
+    map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        throw std::logic_error("mmap() failed");
+    data_ = static_cast<const unsigned char *>(map);
+
+    // frame headers only, nothing is decompressed here
+    for (std::size_t offset = 0; offset < size_; ) {
+        auto size = ZSTD_findFrameCompressedSize(data_ + offset, size_ - offset);
+
+        if (ZSTD_isError(size)) {
+            munmap(map, size_);
+            throw std::logic_error("Corrupt zstd file");
+        }
+
+        frames_.push_back({ offset, size });
+        offset += size;
+    }
+
+    dctx_ = ZSTD_createDCtx();
+    if (!dctx_) {
+        munmap(map, size_);
+        throw std::logic_error("Failed to setup zstd");
+    }
+}
+
+ZstdFile::~ZstdFile()
+{
+    ZSTD_freeDCtx(dctx_);
+    munmap(const_cast<unsigned char *>(data_), size_);
+}
+
+void ZstdFile::read_chunk(std::size_t idx, std::string& out, std::size_t lines)
+{
+    const auto& frame = frames_[idx];
+    ZSTD_inBuffer in{ data_ + frame.offset, frame.size, 0 };
+    std::size_t ret = 1, limit = TRIM_SIZE;
+
+    ZSTD_DCtx_reset(dctx_, ZSTD_reset_session_only);
+
+    while (in.pos < in.size || ret) {
+        auto used = out.size();
+
+        out.resize(used + ZSTD_DStreamOutSize());
+
+        ZSTD_outBuffer buf{ out.data() + used, ZSTD_DStreamOutSize(), 0 };
+
+        ret = ZSTD_decompressStream(dctx_, &buf, &in);
+        if (ZSTD_isError(ret))
+            throw std::logic_error("Corrupt zstd file");
+
+        out.resize(used + buf.pos);
+
+        // keep memory bounded, trimming is amortized by doubling the limit
+        if (out.size() >= limit) {
+            trim(out, lines);
+            limit = std::max(TRIM_SIZE, 2 * out.size());
+        }
+
+        // truncated frame
+        if (in.pos == in.size && ret && !buf.pos)
+            throw std::logic_error("Unexpected end of zstd file");
+    }
+}
+
+#endif
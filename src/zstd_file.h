@@ -0,0 +1,72 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _ZSTD_FILE_H_
+#define _ZSTD_FILE_H_
+
+#include <ktailng_config.h>
+
+#ifdef HAVE_ZSTD
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <zstd.h>
+
+#include <compressed_file.h>
+
+// Zstd frames are independent of each other, so every frame is a chunk. Files
+// consisting of a single frame have to be decompressed as a whole, but only a
+// window of the last lines is kept.
+class ZstdFile : public CompressedFile
+{
+public:
+    ZstdFile(const std::string& filename);
+
+    virtual ~ZstdFile();
+
+protected:
+    virtual std::size_t chunks() const override
+    {
+        return frames_.size();
+    }
+
+    virtual void read_chunk(std::size_t idx, std::string& out, std::size_t lines) override;
+
+private:
+    struct Frame {
+        std::size_t offset;
+        std::size_t size;
+    };
+
+    std::vector<Frame> frames_;
+    const unsigned char *data_;
+    std::size_t size_;
+    ZSTD_DCtx *dctx_;
+};
+
+#endif
+
+#endif /* _ZSTD_FILE_H_ */
@@ -0,0 +1,389 @@
+// Copyright 2019 Kurt Kanzenbach <kurt@kmk-computers.de>
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Soak test for follow mode: a generator appends sequence numbered lines to a
+// file, which is truncated, copytruncated and renamed meanwhile, while
+// ktailng -f follows it. Every line has to show up exactly once and in order.
+// The lag between writing a line and reading it back is reported.
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <latency.h>
+
+#include <kopt/kopt.h>
+
+namespace {
+
+constexpr std::chrono::seconds TIMEOUT{10};
+
+std::uint64_t now_ns()
+{
+    // monotonic clock is shared by all processes
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Reads ktailng's output and checks the sequence numbers.
+class Checker
+{
+public:
+    Checker(int fd) :
+        file_{fdopen(fd, "r")}, seen_{0}, errors_{0}
+    {
+        if (!file_)
+            throw std::logic_error("fdopen() failed");
+    }
+
+    virtual ~Checker()
+    {
+        fclose(file_);
+    }
+
+    void run()
+    {
+        char *line = nullptr;
+        std::size_t len = 0;
+
+        while (getline(&line, &len, file_) > 0) {
+            unsigned long long seq, stamp;
+            auto now = now_ns();
+
+            if (sscanf(line, "%llu %llu", &seq, &stamp) != 2) {
+                error("Unexpected line: " + std::string(line));
+                continue;
+            }
+
+            std::lock_guard lock(mutex_);
+
+            if (seq != seen_ + 1)
+                error("Expected line " + std::to_string(seen_ + 1) +
+                      ", got " + std::to_string(seq));
+            if (seq > seen_)
+                seen_ = seq;
+
+            latency_.record(std::chrono::nanoseconds(now - stamp));
+            cond_.notify_all();
+        }
+
+        free(line);
+    }
+
+    // waits until line @seq has been seen
+    bool wait(std::uint64_t seq)
+    {
+        std::unique_lock lock(mutex_);
+
+        return cond_.wait_for(lock, TIMEOUT, [&] { return seen_ >= seq; });
+    }
+
+    std::size_t errors() const
+    {
+        return errors_;
+    }
+
+    void report(std::ostream& os) const
+    {
+        using us = std::chrono::duration<double, std::micro>;
+        auto p = [this](double percent) { return us(latency_.percentile(percent)).count(); };
+
+        os << "lag: " << latency_.count() << " lines"
+           << ", p50 " << p(50) << " us"
+           << ", p90 " << p(90) << " us"
+           << ", p99 " << p(99) << " us"
+           << ", p99.9 " << p(99.9) << " us"
+           << ", max " << p(100) << " us" << std::endl;
+    }
+
+private:
+    FILE *file_;
+    std::uint64_t seen_;
+    std::size_t errors_;
+    LatencyHistogram latency_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+
+    void error(const std::string& msg)
+    {
+        // the first ones tell the story
+        if (errors_++ < 10)
+            std::cerr << "Error: " << msg << std::endl;
+    }
+};
+
+// Appends lines and rotates the file every now and then.
+class Generator
+{
+public:
+    enum class Rotation {
+        TRUNCATE,
+        COPYTRUNCATE,
+        RENAME,
+    };
+
+    Generator(const std::string& filename, Checker& checker, std::size_t size) :
+        filename_{filename}, checker_{checker}, size_{size}, fd_{-1}
+    {
+        open();
+    }
+
+    virtual ~Generator()
+    {
+        close(fd_);
+    }
+
+    void append(std::uint64_t seq)
+    {
+        auto line = std::to_string(seq) + " " + std::to_string(now_ns()) + " ";
+
+        if (line.size() + 1 < size_)
+            line.append(size_ - line.size() - 1, 'x');
+        line += '\n';
+
+        if (write(fd_, line.data(), line.size()) != static_cast<ssize_t>(line.size()))
+            throw std::logic_error("write() failed");
+    }
+
+    // @last is the last line written
+    void rotate(Rotation rotation, std::uint64_t last)
+    {
+        switch (rotation) {
+        case Rotation::TRUNCATE:
+            // unread data is lost on truncation by design, so wait for it
+            drain(last);
+            if (ftruncate(fd_, 0))
+                throw std::logic_error("ftruncate() failed");
+            break;
+        case Rotation::COPYTRUNCATE:
+            drain(last);
+            copy(filename_ + ".1");
+            if (ftruncate(fd_, 0))
+                throw std::logic_error("ftruncate() failed");
+            break;
+        case Rotation::RENAME:
+            // lines still in the old file must not get lost
+            close(fd_);
+            if (rename(filename_.c_str(), (filename_ + ".1").c_str()))
+                throw std::logic_error("rename() failed");
+            open();
+            break;
+        }
+    }
+
+private:
+    std::string filename_;
+    Checker& checker_;
+    std::size_t size_;
+    int fd_;
+
+    void open()
+    {
+        fd_ = ::open(filename_.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+        if (fd_ < 0)
+            throw std::logic_error("open() failed");
+    }
+
+    void drain(std::uint64_t last)
+    {
+        if (!checker_.wait(last))
+            throw std::logic_error("ktailng stalled before line " + std::to_string(last));
+    }
+
+    void copy(const std::string& target)
+    {
+        std::vector<char> buf(64 * 1024);
+        auto in = ::open(filename_.c_str(), O_RDONLY);
+        auto out = ::open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        ssize_t rc;
+
+        if (in < 0 || out < 0)
+            throw std::logic_error("open() failed");
+
+        while ((rc = read(in, buf.data(), buf.size())) > 0)
+            if (write(out, buf.data(), rc) != rc)
+                throw std::logic_error("write() failed");
+
+        close(in);
+        close(out);
+    }
+};
+
+pid_t spawn(const std::vector<std::string>& args, int out)
+{
+    std::vector<char *> argv;
+
+    for (auto&& arg : args)
+        argv.push_back(const_cast<char *>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    auto pid = fork();
+    if (pid < 0)
+        throw std::logic_error("fork() failed");
+
+    if (!pid) {
+        dup2(out, STDOUT_FILENO);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+
+    return pid;
+}
+
+[[noreturn]] void print_usage_and_die(const Kopt::OptionParser& parser, int die)
+{
+    std::cerr << parser.get_usage("<ktailng>");
+    std::exit(die ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    Kopt::OptionParser parser{argc, argv};
+    std::size_t lines = 20000, size = 64, rotate = 2000;
+    double rate = 5000;
+
+    parser.add_flag_option("help", "print this help text", 'h');
+    parser.add_argument_option("lines", "number of <lines> to write", 'l');
+    parser.add_argument_option("rate", "write <lines> per second", 'r');
+    parser.add_argument_option("size", "<bytes> per line", 's');
+    parser.add_argument_option("rotate", "rotate every <lines> lines", 'R');
+    parser.add_argument_option("number", "buffer size of ktailng in <lines>", 'n');
+    parser.add_flag_option("low-latency", "run ktailng in low latency mode", 'L');
+
+    try {
+        parser.parse();
+
+        if (*parser["help"])
+            print_usage_and_die(parser, 0);
+        if (parser.unparsed_options().size() != 1)
+            throw std::logic_error("Path to ktailng expected.");
+
+        if (*parser["lines"])
+            lines = parser["lines"]->to<std::size_t>();
+        if (*parser["rate"])
+            rate = parser["rate"]->to<double>();
+        if (*parser["size"])
+            size = parser["size"]->to<std::size_t>();
+        if (*parser["rotate"])
+            rotate = parser["rotate"]->to<std::size_t>();
+        if (!lines || rate <= 0)
+            throw std::logic_error("Invalid number of lines or rate.");
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        print_usage_and_die(parser, 1);
+    }
+
+    char dir[] = "/tmp/follow_soak.XXXXXX";
+    if (!mkdtemp(dir)) {
+        std::cerr << "Error: mkdtemp() failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string filename = std::string(dir) + "/soak.log";
+    std::vector<std::string> args{ parser.unparsed_options()[0], "-f", "-n",
+        *parser["number"] ? parser["number"]->to<std::string>() : "1" };
+    pid_t pid = -1;
+    int fds[2];
+    auto failed = false;
+
+    if (*parser["low-latency"])
+        args.push_back("-L");
+
+    try {
+        if (pipe(fds))
+            throw std::logic_error("pipe() failed");
+
+        Checker checker(fds[0]);
+        Generator generator(filename, checker, size);
+
+        args.push_back(filename);
+        pid = spawn(args, fds[1]);
+        close(fds[1]);
+
+        std::thread checker_thread(&Checker::run, &checker);
+
+        try {
+            auto start = std::chrono::steady_clock::now();
+            auto rotation = Generator::Rotation::TRUNCATE;
+
+            // first line tells that ktailng is up
+            generator.append(1);
+            if (!checker.wait(1))
+                throw std::logic_error("ktailng didn't start");
+
+            for (std::uint64_t seq = 2; seq <= lines; ++seq) {
+                std::this_thread::sleep_until(start + std::chrono::duration<double>(seq / rate));
+
+                generator.append(seq);
+
+                if (rotate && !(seq % rotate) && seq != lines) {
+                    generator.rotate(rotation, seq);
+                    rotation = rotation == Generator::Rotation::RENAME ?
+                        Generator::Rotation::TRUNCATE :
+                        static_cast<Generator::Rotation>(static_cast<int>(rotation) + 1);
+                }
+            }
+
+            if (!checker.wait(lines))
+                throw std::logic_error("Not all lines arrived");
+        } catch (const std::exception& ex) {
+            std::cerr << "Error: " << ex.what() << std::endl;
+            failed = true;
+        }
+
+        kill(pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+        checker_thread.join();
+
+        checker.report(std::cout);
+        failed = failed || checker.errors();
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        failed = true;
+    }
+
+    unlink(filename.c_str());
+    unlink((filename + ".1").c_str());
+    rmdir(dir);
+
+    std::cout << (failed ? "FAILED" : "OK") << std::endl;
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}